@@ -0,0 +1,53 @@
+// Measures the cost of calling a compiled Lox function from C++ compared
+// with re-running the whole script for each input.
+// Build from the repository root with:
+//   g++ -std=c++20 -O2 -pthread -Isrc bench/embed.cpp $(ls src/*.cpp |
+//       grep -v -e main.cpp -e AstPrinterDriver.cpp) -o embed_bench
+#include <any>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include "Lox.hpp"
+
+static const char* rules = R"(
+fun score(amount, country) {
+  var s = 0;
+  if (amount > 1000) s = s + 2;
+  if (country == "NZ") s = s + 1;
+  return s;
+}
+)";
+
+template <class F>
+static double seconds(F body) {
+  auto start = std::chrono::steady_clock::now();
+  body();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+  const int calls = 200000;
+  std::ostringstream out, err;
+  Lox lox(out, err);
+
+  std::shared_ptr<LoxProgram> program = lox.compile(rules);
+  if(!program || !program->run()) return 1;
+  LoxEntryPoint score = program->function("score");
+
+  double total = 0;
+  double invoke = seconds([&] {
+    for(int i = 0; i < calls; i++) {
+      total += std::any_cast<double>(score(i % 2000, i % 3 ? "NZ" : "AU"));
+    }
+  });
+  std::printf("invoke: %.2f us/call (checksum %.0f)\n", invoke / calls * 1e6, total);
+
+  const int runs = calls / 100;
+  double rerun = seconds([&] {
+    for(int i = 0; i < runs; i++) {
+      lox.run(std::string(rules) + "print score(" + std::to_string(i % 2000) + ", \"NZ\");");
+    }
+  });
+  std::printf("re-run: %.2f us/call\n", rerun / runs * 1e6);
+}
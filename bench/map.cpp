@@ -0,0 +1,52 @@
+// Compares LoxMap with std::unordered_map on number and string keys.
+// Build from the repository root with:
+//   g++ -std=c++20 -O2 -Isrc bench/map.cpp src/LoxMap.cpp src/LoxList.cpp
+//       src/LoxString.cpp src/Environment.cpp -o map_bench
+#include <any>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LoxMap.hpp"
+#include "LoxString.hpp"
+
+template <class F>
+static double seconds(F body) {
+  auto start = std::chrono::steady_clock::now();
+  body();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+  size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  double checksum = 0;
+
+  std::vector<double> numbers;
+  std::vector<std::shared_ptr<LoxString>> strings;
+  for(size_t i = 0; i < n; i++) {
+    numbers.push_back(static_cast<double>(i * 7919 % (n * 2)));
+    strings.push_back(std::make_shared<LoxString>("key-" + std::to_string(i)));
+  }
+
+  LoxMap loxNumbers;
+  std::unordered_map<double, std::any> stdNumbers;
+  double loxInsert = seconds([&] { for(double key : numbers) loxNumbers.set(key, key); });
+  double stdInsert = seconds([&] { for(double key : numbers) stdNumbers[key] = key; });
+  double loxLookup = seconds([&] { for(double key : numbers) checksum += std::any_cast<double>(*loxNumbers.find(key)); });
+  double stdLookup = seconds([&] { for(double key : numbers) checksum += std::any_cast<double>(stdNumbers.find(key)->second); });
+  std::printf("number keys  insert: LoxMap %.3fs  unordered_map %.3fs\n", loxInsert, stdInsert);
+  std::printf("number keys  lookup: LoxMap %.3fs  unordered_map %.3fs\n", loxLookup, stdLookup);
+
+  LoxMap loxStrings;
+  std::unordered_map<std::string, std::any> stdStrings;
+  loxInsert = seconds([&] { for(auto& key : strings) loxStrings.set(key, 1.0); });
+  stdInsert = seconds([&] { for(auto& key : strings) stdStrings[key->str()] = 1.0; });
+  loxLookup = seconds([&] { for(auto& key : strings) checksum += std::any_cast<double>(*loxStrings.find(key)); });
+  stdLookup = seconds([&] { for(auto& key : strings) checksum += std::any_cast<double>(stdStrings.find(key->str())->second); });
+  std::printf("string keys  insert: LoxMap %.3fs  unordered_map %.3fs\n", loxInsert, stdInsert);
+  std::printf("string keys  lookup: LoxMap %.3fs  unordered_map %.3fs\n", loxLookup, stdLookup);
+
+  std::printf("checksum %.0f\n", checksum);
+  return 0;
+}
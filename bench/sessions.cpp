@@ -0,0 +1,57 @@
+// Runs independent Lox sessions on 1..N threads and reports throughput.
+// Build from the repository root with:
+//   g++ -std=c++20 -O2 -pthread -Isrc bench/sessions.cpp $(ls src/*.cpp |
+//       grep -v -e main.cpp -e AstPrinterDriver.cpp) -o sessions_bench
+// Usage: sessions_bench [max threads] [scripts per thread]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Lox.hpp"
+
+static const char* script = R"(
+fun fib(n) {
+  if (n < 2) return n;
+  return fib(n - 1) + fib(n - 2);
+}
+var total = 0;
+for (var i = 0; i < 10; i = i + 1) total = total + fib(15);
+print total;
+)";
+
+int main(int argc, char* argv[]) {
+  unsigned maxThreads = argc > 1 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+  int perThread = argc > 2 ? std::atoi(argv[2]) : 20;
+  if(maxThreads == 0) maxThreads = 1;
+
+  double baseline = 0;
+  for(unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+    std::atomic<int> failures{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for(unsigned t = 0; t < threads; t++) {
+      workers.emplace_back([&] {
+        for(int i = 0; i < perThread; i++) {
+          std::ostringstream out, err;
+          {
+            Lox lox(out, err);
+            lox.run(script);
+            lox.flush();
+            if(lox.failed()) failures++;
+          }
+          if(out.str() != "6100\n") failures++;
+        }
+      });
+    }
+    for(std::thread& worker : workers) worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double rate = threads * perThread / seconds;
+    if(threads == 1) baseline = rate;
+    std::printf("%3u threads: %8.1f scripts/s  speedup %.2fx%s\n",
+      threads, rate, rate / baseline, failures ? "  (wrong output)" : "");
+  }
+}
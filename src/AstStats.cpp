@@ -0,0 +1,245 @@
+#include "AstStats.hpp"
+#include "Environment.hpp"
+#include "LoxFunction.hpp"
+#include "LoxClass.hpp"
+#include "LoxInstance.hpp"
+#include "LoxList.hpp"
+#include "LoxMap.hpp"
+#include "LoxString.hpp"
+
+// Reference counts and allocator header of a make_shared allocation.
+static constexpr size_t controlBlockSize = 16;
+
+AstStats AstStats::measure(Environment& globals) {
+  AstStats stats;
+  stats.add(globals);
+  while(!stats.pending.empty()) {
+    std::any value = std::move(stats.pending.back());
+    stats.pending.pop_back();
+    stats.addValue(value);
+  }
+  return stats;
+}
+
+bool AstStats::visit(const void* object) {
+  return object != nullptr && seen.insert(object).second;
+}
+
+void AstStats::addNode(size_t size) {
+  nodes++;
+  bytes += size + controlBlockSize;
+}
+
+void AstStats::add(const std::shared_ptr<Expr>& expr) {
+  if(expr != nullptr && visit(expr.get())) expr->accept(*this);
+}
+
+void AstStats::add(const std::shared_ptr<Stmt>& stmt) {
+  if(stmt != nullptr && visit(stmt.get())) stmt->accept(*this);
+}
+
+void AstStats::add(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  bytes += statements.capacity() * sizeof(std::shared_ptr<Stmt>);
+  for(const std::shared_ptr<Stmt>& stmt : statements) add(stmt);
+}
+
+void AstStats::add(Environment& environment) {
+  // Environments are walked without recursion: closures can nest deeply.
+  for(Environment* scope = &environment; scope != nullptr && visit(scope); scope = scope->enclosing.get()) {
+    for(auto& [name, value] : scope->values) pending.push_back(value);
+  }
+}
+
+void AstStats::addValue(const std::any& value) {
+  if(value.type() == typeid(std::shared_ptr<LoxFunction>)) {
+    auto& function = std::any_cast<const std::shared_ptr<LoxFunction>&>(value);
+    if(!visit(function.get())) return;
+    add(std::static_pointer_cast<Stmt>(function->declaration));
+    if(function->closure != nullptr) add(*function->closure);
+  } else if(value.type() == typeid(std::shared_ptr<LoxClass>)) {
+    auto& klass = std::any_cast<const std::shared_ptr<LoxClass>&>(value);
+    if(!visit(klass.get())) return;
+    for(auto& [name, method] : klass->methods) pending.push_back(method);
+    if(klass->superClass != nullptr) pending.push_back(klass->superClass);
+  } else if(value.type() == typeid(std::shared_ptr<LoxInstance>)) {
+    auto& instance = std::any_cast<const std::shared_ptr<LoxInstance>&>(value);
+    if(!visit(instance.get())) return;
+    pending.push_back(instance->klass);
+    for(auto& [name, field] : instance->fields) pending.push_back(field);
+  } else if(value.type() == typeid(std::shared_ptr<LoxList>)) {
+    auto& list = std::any_cast<const std::shared_ptr<LoxList>&>(value);
+    if(!visit(list.get())) return;
+    for(const std::any& element : list->elements) pending.push_back(element);
+  } else if(value.type() == typeid(std::shared_ptr<LoxMap>)) {
+    auto& map = std::any_cast<const std::shared_ptr<LoxMap>&>(value);
+    if(!visit(map.get())) return;
+    for(auto [key, item] : map->items()) pending.push_back(*item);
+  }
+}
+
+std::any AstStats::visitBlockStmt(Block& stmt) {
+  addNode(sizeof(Block));
+  add(stmt.statements);
+  return {};
+}
+
+std::any AstStats::visitExpressionStmt(Expression& stmt) {
+  addNode(sizeof(Expression));
+  add(stmt.expression);
+  return {};
+}
+
+std::any AstStats::visitFunctionStmt(Function& stmt) {
+  addNode(sizeof(Function));
+  bytes += stmt.params.capacity() * sizeof(Token);
+  add(stmt.body);
+  return {};
+}
+
+std::any AstStats::visitIfStmt(If& stmt) {
+  addNode(sizeof(If));
+  add(stmt.condition);
+  add(stmt.thenBranch);
+  add(stmt.elseBranch);
+  return {};
+}
+
+std::any AstStats::visitPrintStmt(Print& stmt) {
+  addNode(sizeof(Print));
+  add(stmt.expression);
+  return {};
+}
+
+std::any AstStats::visitClassStmt(Class& stmt) {
+  addNode(sizeof(Class));
+  add(std::static_pointer_cast<Expr>(stmt.superclass));
+  bytes += stmt.methods.capacity() * sizeof(std::shared_ptr<Function>);
+  for(auto& method : stmt.methods) add(std::static_pointer_cast<Stmt>(method));
+  return {};
+}
+
+std::any AstStats::visitReturnStmt(Return& stmt) {
+  addNode(sizeof(Return));
+  add(stmt.value);
+  return {};
+}
+
+std::any AstStats::visitVarStmt(Var& stmt) {
+  addNode(sizeof(Var));
+  add(stmt.initializer);
+  return {};
+}
+
+std::any AstStats::visitWhileStmt(While& stmt) {
+  addNode(sizeof(While));
+  add(stmt.condition);
+  add(stmt.body);
+  return {};
+}
+
+std::any AstStats::visitForStmt(For& stmt) {
+  addNode(sizeof(For));
+  add(stmt.initializer);
+  add(stmt.condition);
+  add(stmt.increment);
+  add(stmt.body);
+  return {};
+}
+
+std::any AstStats::visitAssignExpr(Assign& expr) {
+  addNode(sizeof(Assign));
+  add(expr.value);
+  return {};
+}
+
+std::any AstStats::visitBinaryExpr(Binary& expr) {
+  addNode(sizeof(Binary));
+  add(expr.left);
+  add(expr.right);
+  return {};
+}
+
+std::any AstStats::visitCallExpr(Call& expr) {
+  addNode(sizeof(Call));
+  add(expr.callee);
+  bytes += expr.arguments.capacity() * sizeof(std::shared_ptr<Expr>);
+  for(auto& argument : expr.arguments) add(argument);
+  return {};
+}
+
+std::any AstStats::visitGroupingExpr(Grouping& expr) {
+  addNode(sizeof(Grouping));
+  add(expr.expression);
+  return {};
+}
+
+std::any AstStats::visitLiteralExpr(Literal& expr) {
+  addNode(sizeof(Literal));
+  if(expr.value.type() == typeid(std::shared_ptr<LoxString>)) {
+    bytes += sizeof(LoxString) + controlBlockSize + std::any_cast<const std::shared_ptr<LoxString>&>(expr.value)->size();
+  }
+  return {};
+}
+
+std::any AstStats::visitLogicalExpr(Logical& expr) {
+  addNode(sizeof(Logical));
+  add(expr.left);
+  add(expr.right);
+  return {};
+}
+
+std::any AstStats::visitUnaryExpr(Unary& expr) {
+  addNode(sizeof(Unary));
+  add(expr.right);
+  return {};
+}
+
+std::any AstStats::visitGetExpr(Get& expr) {
+  addNode(sizeof(Get));
+  add(expr.object);
+  return {};
+}
+
+std::any AstStats::visitSetExpr(Set& expr) {
+  addNode(sizeof(Set));
+  add(expr.object);
+  add(expr.value);
+  return {};
+}
+
+std::any AstStats::visitThisExpr(This& expr) {
+  addNode(sizeof(This));
+  return {};
+}
+
+std::any AstStats::visitSuperExpr(Super& expr) {
+  addNode(sizeof(Super));
+  return {};
+}
+
+std::any AstStats::visitVariableExpr(Variable& expr) {
+  addNode(sizeof(Variable));
+  return {};
+}
+
+std::any AstStats::visitIndexExpr(Index& expr) {
+  addNode(sizeof(Index));
+  add(expr.object);
+  add(expr.index);
+  return {};
+}
+
+std::any AstStats::visitSetIndexExpr(SetIndex& expr) {
+  addNode(sizeof(SetIndex));
+  add(expr.object);
+  add(expr.index);
+  add(expr.value);
+  return {};
+}
+
+std::any AstStats::visitListLiteralExpr(ListLiteral& expr) {
+  addNode(sizeof(ListLiteral));
+  bytes += expr.elements.capacity() * sizeof(std::shared_ptr<Expr>);
+  for(auto& element : expr.elements) add(element);
+  return {};
+}
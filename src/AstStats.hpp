@@ -0,0 +1,62 @@
+#ifndef __ASTSTATS_H
+#define __ASTSTATS_H
+
+#include <any>
+#include <memory>
+#include <unordered_set>
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+class Environment;
+
+// Measures the syntax tree a session still holds: the declarations of
+// every function and class reachable from its globals, through closures,
+// instances, lists and maps. Everything else is freed once the statement
+// that created it has run. Sizes are estimates: the node itself, its
+// shared_ptr control block and the arrays it owns.
+class AstStats : public ExprVisitor, public StmtVisitor {
+  std::unordered_set<const void*> seen;
+  std::vector<std::any> pending;
+
+  bool visit(const void* object);
+  void addNode(size_t size);
+  void add(const std::shared_ptr<Expr>& expr);
+  void add(const std::shared_ptr<Stmt>& stmt);
+  void add(const std::vector<std::shared_ptr<Stmt>>& statements);
+  void add(Environment& environment);
+  void addValue(const std::any& value);
+public:
+  size_t nodes = 0;
+  size_t bytes = 0;
+
+  static AstStats measure(Environment& globals);
+
+  std::any visitBlockStmt(Block& stmt) override;
+  std::any visitExpressionStmt(Expression& stmt) override;
+  std::any visitFunctionStmt(Function& stmt) override;
+  std::any visitIfStmt(If& stmt) override;
+  std::any visitPrintStmt(Print& stmt) override;
+  std::any visitClassStmt(Class& stmt) override;
+  std::any visitReturnStmt(Return& stmt) override;
+  std::any visitVarStmt(Var& stmt) override;
+  std::any visitWhileStmt(While& stmt) override;
+  std::any visitForStmt(For& stmt) override;
+
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
+};
+
+#endif
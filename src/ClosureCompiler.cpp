@@ -0,0 +1,425 @@
+#include "ClosureCompiler.hpp"
+#include "RuntimeError.hpp"
+#include "LoxFunction.hpp"
+#include "LoxClass.hpp"
+#include "LoxInstance.hpp"
+#include "LoxNative.hpp"
+#include "LoxReturn.hpp"
+#include "LoxString.hpp"
+#include "LoxList.hpp"
+
+using Eval = ClosureCompiler::Eval;
+using Exec = ClosureCompiler::Exec;
+
+std::vector<Exec> ClosureCompiler::compile(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  ClosureCompiler compiler;
+  std::vector<Exec> compiled;
+  compiled.reserve(statements.size());
+  for(const std::shared_ptr<Stmt>& stmt : statements) {
+    compiled.push_back(compiler.compile(stmt));
+  }
+  return compiled;
+}
+
+void ClosureCompiler::executeBlock(Interpreter& interpreter, const std::vector<Exec>& statements, std::shared_ptr<Environment> environment) {
+  std::shared_ptr<Environment> previous = std::move(interpreter.environment);
+  try {
+    interpreter.environment = std::move(environment);
+    for(const Exec& statement : statements) {
+      statement(interpreter);
+    }
+  } catch (...) {
+    interpreter.environment = std::move(previous);
+    throw;
+  }
+  interpreter.environment = std::move(previous);
+}
+
+Eval ClosureCompiler::compile(const std::shared_ptr<Expr>& expr) {
+  return std::any_cast<Eval>(expr->accept(*this));
+}
+
+Exec ClosureCompiler::compile(const std::shared_ptr<Stmt>& stmt) {
+  return std::any_cast<Exec>(stmt->accept(*this));
+}
+
+void ClosureCompiler::compileBody(Function& function) {
+  auto body = std::make_shared<ClosureBody>();
+  body->statements.reserve(function.body.size());
+  for(const std::shared_ptr<Stmt>& stmt : function.body) {
+    body->statements.push_back(compile(stmt));
+  }
+  function.closureBody = std::move(body);
+}
+
+std::any ClosureCompiler::visitBlockStmt(Block& stmt) {
+  std::vector<Exec> statements;
+  statements.reserve(stmt.statements.size());
+  for(const std::shared_ptr<Stmt>& statement : stmt.statements) {
+    statements.push_back(compile(statement));
+  }
+  return Exec([statements = std::move(statements)](Interpreter& interpreter) {
+    executeBlock(interpreter, statements, std::make_shared<Environment>(interpreter.environment));
+  });
+}
+
+std::any ClosureCompiler::visitExpressionStmt(Expression& stmt) {
+  return Exec([expression = compile(stmt.expression)](Interpreter& interpreter) {
+    expression(interpreter);
+  });
+}
+
+std::any ClosureCompiler::visitFunctionStmt(Function& stmt) {
+  compileBody(stmt);
+  // The closure lives no longer than the program that owns the node.
+  return Exec([function = &stmt](Interpreter& interpreter) {
+    interpreter.visitFunctionStmt(*function);
+  });
+}
+
+std::any ClosureCompiler::visitIfStmt(If& stmt) {
+  Eval condition = compile(stmt.condition);
+  Exec thenBranch = compile(stmt.thenBranch);
+  if(stmt.elseBranch == nullptr) {
+    return Exec([condition, thenBranch, type = stmt.conditionType](Interpreter& interpreter) {
+      std::any value = condition(interpreter);
+      if(interpreter.isTruthy(value, type)) thenBranch(interpreter);
+    });
+  }
+  return Exec([condition, thenBranch, elseBranch = compile(stmt.elseBranch), type = stmt.conditionType](Interpreter& interpreter) {
+    std::any value = condition(interpreter);
+    if(interpreter.isTruthy(value, type)) thenBranch(interpreter);
+    else elseBranch(interpreter);
+  });
+}
+
+std::any ClosureCompiler::visitPrintStmt(Print& stmt) {
+  return Exec([expression = compile(stmt.expression)](Interpreter& interpreter) {
+    std::any value = expression(interpreter);
+    interpreter.print(value);
+  });
+}
+
+std::any ClosureCompiler::visitClassStmt(Class& stmt) {
+  for(const std::shared_ptr<Function>& method : stmt.methods) {
+    compileBody(*method);
+  }
+  return Exec([klass = &stmt](Interpreter& interpreter) {
+    interpreter.visitClassStmt(*klass);
+  });
+}
+
+std::any ClosureCompiler::visitReturnStmt(Return& stmt) {
+  if(stmt.value == nullptr) {
+    return Exec([](Interpreter&) { throw LoxReturn(nullptr); });
+  }
+  return Exec([value = compile(stmt.value)](Interpreter& interpreter) {
+    throw LoxReturn(value(interpreter));
+  });
+}
+
+std::any ClosureCompiler::visitVarStmt(Var& stmt) {
+  std::string name = stmt.name.lexeme;
+  if(stmt.initializer == nullptr) {
+    return Exec([name](Interpreter& interpreter) {
+      interpreter.environment->define(name, nullptr);
+    });
+  }
+  return Exec([name, initializer = compile(stmt.initializer)](Interpreter& interpreter) {
+    interpreter.environment->define(name, initializer(interpreter));
+  });
+}
+
+std::any ClosureCompiler::visitWhileStmt(While& stmt) {
+  return Exec([condition = compile(stmt.condition), body = compile(stmt.body), type = stmt.conditionType](Interpreter& interpreter) {
+    std::any value = condition(interpreter);
+    while(interpreter.isTruthy(value, type)) {
+      body(interpreter);
+      value = condition(interpreter);
+    }
+  });
+}
+
+std::any ClosureCompiler::visitForStmt(For& stmt) {
+  Exec initializer = stmt.initializer == nullptr ? nullptr : compile(stmt.initializer);
+  Eval increment = stmt.increment == nullptr ? nullptr : compile(stmt.increment);
+  // A reusable block body is compiled to its statements, which run in one
+  // environment made when the loop starts.
+  std::vector<Exec> block;
+  Exec body = nullptr;
+  Block* bodyBlock = stmt.reuseBodyScope ? dynamic_cast<Block*>(stmt.body.get()) : nullptr;
+  if(bodyBlock != nullptr) {
+    block.reserve(bodyBlock->statements.size());
+    for(const std::shared_ptr<Stmt>& statement : bodyBlock->statements) {
+      block.push_back(compile(statement));
+    }
+  } else {
+    body = compile(stmt.body);
+  }
+  auto loop = [condition = compile(stmt.condition), increment, block = std::move(block), body, reuse = bodyBlock != nullptr, type = stmt.conditionType](Interpreter& interpreter) {
+    std::shared_ptr<Environment> bodyEnvironment;
+    if(reuse) bodyEnvironment = std::make_shared<Environment>(interpreter.environment);
+    std::any value = condition(interpreter);
+    while(interpreter.isTruthy(value, type)) {
+      if(reuse) executeBlock(interpreter, block, bodyEnvironment);
+      else body(interpreter);
+      if(increment) increment(interpreter);
+      value = condition(interpreter);
+    }
+  };
+  if(initializer == nullptr) return Exec(std::move(loop));
+  return Exec([initializer, loop = std::move(loop)](Interpreter& interpreter) {
+    std::shared_ptr<Environment> previous = interpreter.environment;
+    try {
+      interpreter.environment = std::make_shared<Environment>(previous);
+      initializer(interpreter);
+      loop(interpreter);
+    } catch (...) {
+      interpreter.environment = std::move(previous);
+      throw;
+    }
+    interpreter.environment = std::move(previous);
+  });
+}
+
+std::any ClosureCompiler::visitAssignExpr(Assign& expr) {
+  Eval value = compile(expr.value);
+  if(expr.depth >= 0) {
+    return Eval([name = expr.name, depth = expr.depth, value](Interpreter& interpreter) {
+      std::any result = value(interpreter);
+      interpreter.environment->assignAt(depth, name, result);
+      return result;
+    });
+  }
+  return Eval([assign = &expr, value](Interpreter& interpreter) {
+    std::any result = value(interpreter);
+    *interpreter.globalCell(assign->name, assign->global) = result;
+    return result;
+  });
+}
+
+// Arithmetic and comparison on two numbers, with the operation chosen
+// when the closure is built. Operands TypeInference proved to be numbers
+// are not checked.
+template<typename Operation>
+static Eval numeric(Eval left, Eval right, const Binary& expr, Operation operation) {
+  if(expr.operandType == StaticType::NUMBER) {
+    return [left = std::move(left), right = std::move(right), operation](Interpreter& interpreter) -> std::any {
+      std::any a = left(interpreter);
+      std::any b = right(interpreter);
+      return operation(*std::any_cast<double>(&a), *std::any_cast<double>(&b));
+    };
+  }
+  return [left = std::move(left), right = std::move(right), op = expr.op, operation](Interpreter& interpreter) -> std::any {
+    std::any a = left(interpreter);
+    std::any b = right(interpreter);
+    const double* x = std::any_cast<double>(&a);
+    const double* y = std::any_cast<double>(&b);
+    if(x == nullptr || y == nullptr) throw RuntimeError(op, "Operands must be numbers.");
+    return operation(*x, *y);
+  };
+}
+
+std::any ClosureCompiler::visitBinaryExpr(Binary& expr) {
+  Eval left = compile(expr.left);
+  Eval right = compile(expr.right);
+  const Token& op = expr.op;
+  switch(op.type) {
+    case TokenType::BANG_EQUAL:
+      return Eval([left, right](Interpreter& interpreter) -> std::any {
+        std::any a = left(interpreter);
+        std::any b = right(interpreter);
+        return !interpreter.isEqual(a, b);
+      });
+    case TokenType::EQUAL_EQUAL:
+      return Eval([left, right](Interpreter& interpreter) -> std::any {
+        std::any a = left(interpreter);
+        std::any b = right(interpreter);
+        return interpreter.isEqual(a, b);
+      });
+    case TokenType::GREATER: return numeric(left, right, expr, [](double a, double b) { return a > b; });
+    case TokenType::GREATER_EQUAL: return numeric(left, right, expr, [](double a, double b) { return a >= b; });
+    case TokenType::LESS: return numeric(left, right, expr, [](double a, double b) { return a < b; });
+    case TokenType::LESS_EQUAL: return numeric(left, right, expr, [](double a, double b) { return a <= b; });
+    case TokenType::MINUS: return numeric(left, right, expr, [](double a, double b) { return a - b; });
+    case TokenType::SLASH: return numeric(left, right, expr, [](double a, double b) { return a / b; });
+    case TokenType::STAR: return numeric(left, right, expr, [](double a, double b) { return a * b; });
+    case TokenType::PLUS:
+      if(expr.operandType == StaticType::NUMBER) {
+        return numeric(left, right, expr, [](double a, double b) { return a + b; });
+      }
+      if(expr.operandType == StaticType::STRING) {
+        return Eval([left, right](Interpreter& interpreter) -> std::any {
+          std::any a = left(interpreter);
+          std::any b = right(interpreter);
+          return LoxString::concat(*std::any_cast<std::shared_ptr<LoxString>>(&a), *std::any_cast<std::shared_ptr<LoxString>>(&b));
+        });
+      }
+      return Eval([left, right, op](Interpreter& interpreter) -> std::any {
+        std::any a = left(interpreter);
+        std::any b = right(interpreter);
+        const double* x = std::any_cast<double>(&a);
+        const double* y = std::any_cast<double>(&b);
+        if(x != nullptr && y != nullptr) return *x + *y;
+        auto* s = std::any_cast<std::shared_ptr<LoxString>>(&a);
+        auto* t = std::any_cast<std::shared_ptr<LoxString>>(&b);
+        if(s != nullptr && t != nullptr) return LoxString::concat(*s, *t);
+        throw RuntimeError(op, "Operands must be two numbers or two strings.");
+      });
+  }
+  return Eval([](Interpreter&) { return std::any{}; });
+}
+
+std::any ClosureCompiler::visitCallExpr(Call& expr) {
+  Eval callee = compile(expr.callee);
+  std::vector<Eval> arguments;
+  arguments.reserve(expr.arguments.size());
+  for(const std::shared_ptr<Expr>& argument : expr.arguments) {
+    arguments.push_back(compile(argument));
+  }
+  return Eval([callee, arguments = std::move(arguments), paren = expr.paren](Interpreter& interpreter) {
+    std::any function = callee(interpreter);
+    CallArguments values(arguments.size());
+    for(size_t i = 0; i < arguments.size(); i++) {
+      values[i] = arguments[i](interpreter);
+    }
+    if(auto* loxFunction = std::any_cast<std::shared_ptr<LoxFunction>>(&function)) {
+      return interpreter.call(paren, **loxFunction, false, values.span());
+    }
+    if(auto* native = std::any_cast<std::shared_ptr<LoxNative>>(&function)) {
+      return interpreter.call(paren, **native, true, values.span());
+    }
+    if(auto* loxClass = std::any_cast<std::shared_ptr<LoxClass>>(&function)) {
+      return interpreter.call(paren, **loxClass, false, values.span());
+    }
+    throw RuntimeError(paren, "Can only call functions and classes.");
+  });
+}
+
+std::any ClosureCompiler::visitGroupingExpr(Grouping& expr) {
+  return compile(expr.expression);
+}
+
+std::any ClosureCompiler::visitLiteralExpr(Literal& expr) {
+  return Eval([value = expr.value](Interpreter&) { return value; });
+}
+
+std::any ClosureCompiler::visitLogicalExpr(Logical& expr) {
+  Eval left = compile(expr.left);
+  Eval right = compile(expr.right);
+  if(expr.op.type == TokenType::OR) {
+    return Eval([left, right, type = expr.leftType](Interpreter& interpreter) {
+      std::any value = left(interpreter);
+      if(interpreter.isTruthy(value, type)) return value;
+      return right(interpreter);
+    });
+  }
+  return Eval([left, right, type = expr.leftType](Interpreter& interpreter) {
+    std::any value = left(interpreter);
+    if(!interpreter.isTruthy(value, type)) return value;
+    return right(interpreter);
+  });
+}
+
+std::any ClosureCompiler::visitUnaryExpr(Unary& expr) {
+  Eval right = compile(expr.right);
+  if(expr.op.type == TokenType::BANG) {
+    return Eval([right, type = expr.operandType](Interpreter& interpreter) -> std::any {
+      std::any value = right(interpreter);
+      return !interpreter.isTruthy(value, type);
+    });
+  }
+  if(expr.operandType == StaticType::NUMBER) {
+    return Eval([right](Interpreter& interpreter) -> std::any {
+      std::any value = right(interpreter);
+      return -*std::any_cast<double>(&value);
+    });
+  }
+  return Eval([right, op = expr.op](Interpreter& interpreter) -> std::any {
+    std::any value = right(interpreter);
+    const double* number = std::any_cast<double>(&value);
+    if(number == nullptr) throw RuntimeError(op, "Operands must be numbers.");
+    return -*number;
+  });
+}
+
+std::any ClosureCompiler::visitGetExpr(Get& expr) {
+  return Eval([object = compile(expr.object), name = expr.name](Interpreter& interpreter) mutable {
+    std::any value = object(interpreter);
+    if(auto* instance = std::any_cast<std::shared_ptr<LoxInstance>>(&value)) {
+      return (*instance)->get(name);
+    }
+    throw RuntimeError(name, "Only instances have properties.");
+  });
+}
+
+std::any ClosureCompiler::visitSetExpr(Set& expr) {
+  return Eval([object = compile(expr.object), value = compile(expr.value), name = expr.name](Interpreter& interpreter) {
+    std::any target = object(interpreter);
+    auto* instance = std::any_cast<std::shared_ptr<LoxInstance>>(&target);
+    if(instance == nullptr) {
+      throw RuntimeError(name, "Only instances have fields.");
+    }
+    std::any result = value(interpreter);
+    (*instance)->set(name, result);
+    return result;
+  });
+}
+
+std::any ClosureCompiler::visitThisExpr(This& expr) {
+  return Eval([depth = expr.depth](Interpreter& interpreter) {
+    return interpreter.environment->getAt(depth, "this");
+  });
+}
+
+std::any ClosureCompiler::visitSuperExpr(Super& expr) {
+  return Eval([super = &expr](Interpreter& interpreter) {
+    return interpreter.visitSuperExpr(*super);
+  });
+}
+
+std::any ClosureCompiler::visitVariableExpr(Variable& expr) {
+  if(expr.depth >= 0) {
+    return Eval([name = expr.name.lexeme, depth = expr.depth](Interpreter& interpreter) {
+      return interpreter.environment->getAt(depth, name);
+    });
+  }
+  return Eval([variable = &expr](Interpreter& interpreter) {
+    return *interpreter.globalCell(variable->name, variable->global);
+  });
+}
+
+std::any ClosureCompiler::visitIndexExpr(Index& expr) {
+  return Eval([object = compile(expr.object), index = compile(expr.index), bracket = expr.bracket](Interpreter& interpreter) {
+    std::any target = object(interpreter);
+    std::any position = index(interpreter);
+    return interpreter.index(bracket, target, position);
+  });
+}
+
+std::any ClosureCompiler::visitSetIndexExpr(SetIndex& expr) {
+  return Eval([object = compile(expr.object), index = compile(expr.index), value = compile(expr.value), bracket = expr.bracket](Interpreter& interpreter) {
+    std::any target = object(interpreter);
+    interpreter.checkIndexable(bracket, target);
+    std::any position = index(interpreter);
+    std::any result = value(interpreter);
+    interpreter.setIndex(bracket, target, position, result);
+    return result;
+  });
+}
+
+std::any ClosureCompiler::visitListLiteralExpr(ListLiteral& expr) {
+  std::vector<Eval> elements;
+  elements.reserve(expr.elements.size());
+  for(const std::shared_ptr<Expr>& element : expr.elements) {
+    elements.push_back(compile(element));
+  }
+  return Eval([elements = std::move(elements)](Interpreter& interpreter) -> std::any {
+    std::vector<std::any> values;
+    values.reserve(elements.size());
+    for(const Eval& element : elements) {
+      values.push_back(element(interpreter));
+    }
+    return std::make_shared<LoxList>(std::move(values));
+  });
+}
@@ -0,0 +1,68 @@
+#ifndef __CLOSURECOMPILER_H
+#define __CLOSURECOMPILER_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Interpreter.hpp"
+
+// The second execution engine, selected with --engine=closure. Before a
+// script runs, every resolved statement and expression is lowered once
+// into a C++ closure that has the node's operator, literal value, name
+// and scope depth baked in. Running the script is then a chain of direct
+// calls through those closures: no accept() double dispatch, no
+// shared_from_this and no switch on the operator. Function bodies are
+// lowered together with the code that declares them and stored on their
+// Function node, where LoxFunction::call picks them up.
+//
+// The closures keep the interpreter's environments and values, so both
+// engines behave identically and share every runtime type. Class
+// declarations and super lookups, which run rarely, are delegated to the
+// interpreter's visitor.
+class ClosureCompiler : public ExprVisitor, public StmtVisitor {
+public:
+  using Eval = std::function<std::any(Interpreter&)>;
+  using Exec = std::function<void(Interpreter&)>;
+
+  static std::vector<Exec> compile(const std::vector<std::shared_ptr<Stmt>>& statements);
+  // Runs compiled statements in `environment`, like Interpreter::executeBlock.
+  static void executeBlock(Interpreter& interpreter, const std::vector<Exec>& statements, std::shared_ptr<Environment> environment);
+
+  std::any visitBlockStmt(Block& stmt) override;
+  std::any visitExpressionStmt(Expression& stmt) override;
+  std::any visitFunctionStmt(Function& stmt) override;
+  std::any visitIfStmt(If& stmt) override;
+  std::any visitPrintStmt(Print& stmt) override;
+  std::any visitClassStmt(Class& stmt) override;
+  std::any visitReturnStmt(Return& stmt) override;
+  std::any visitVarStmt(Var& stmt) override;
+  std::any visitWhileStmt(While& stmt) override;
+  std::any visitForStmt(For& stmt) override;
+
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
+private:
+  Eval compile(const std::shared_ptr<Expr>& expr);
+  Exec compile(const std::shared_ptr<Stmt>& stmt);
+  void compileBody(Function& function);
+};
+
+// A function body lowered by the ClosureCompiler.
+struct ClosureBody {
+  std::vector<ClosureCompiler::Exec> statements;
+};
+
+#endif
@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include "CppEmitter.hpp"
+#include "Environment.hpp"
+#include "Lox.hpp"
+#include "LoxNative.hpp"
+#include "LoxString.hpp"
+
+static std::string quote(const std::string& text) {
+  std::string quoted = "\"";
+  for(char c : text) {
+    switch(c) {
+      case '"': quoted += "\\\""; break;
+      case '\\': quoted += "\\\\"; break;
+      case '\n': quoted += "\\n"; break;
+      case '\r': quoted += "\\r"; break;
+      case '\t': quoted += "\\t"; break;
+      default:
+        if(static_cast<unsigned char>(c) < 0x20) {
+          char escape[8];
+          std::snprintf(escape, sizeof(escape), "\\%03o", static_cast<unsigned char>(c));
+          quoted += escape;
+        } else {
+          quoted += c;
+        }
+    }
+  }
+  return quoted + "\"";
+}
+
+static std::string number(double value) {
+  if(std::isinf(value)) return value > 0 ? "HUGE_VAL" : "-HUGE_VAL";
+  char text[32];
+  std::string digits(text, std::to_chars(text, text + sizeof(text), value).ptr);
+  // Keep integral values double literals.
+  if(digits.find_first_of(".e") == std::string::npos) digits += ".0";
+  return digits;
+}
+
+std::string CppEmitter::emit(const std::vector<std::shared_ptr<Stmt>>& statements, const std::string& fileName) {
+  collecting = true;
+  run(statements);
+  collecting = false;
+  locals.clear();
+  globalNames.clear();
+  strings.clear();
+  properties.clear();
+  prototypes.clear();
+  definitions.clear();
+  body.clear();
+  counter = 0;
+  run(statements);
+
+  std::string program =
+    "// Generated by cppLox --emit-cpp from " + fileName + ". Build it with\n"
+    "//   g++ -std=c++20 -O2 -I<cppLox>/src/runtime <this file> \\\n"
+    "//       <cppLox>/src/runtime/LoxRuntime.cpp <cppLox>/src/OutputBuffer.cpp\n"
+    "#include <cmath>\n"
+    "#include \"LoxRuntime.hpp\"\n\n"
+    "namespace {\n\n";
+  for(const std::string& name : globalNames) {
+    if(name == "clock") {
+      program += "lox::Global g_clock{\"clock\", lox::clockNative()};\n";
+    } else {
+      program += "lox::Global g_" + name + "{\"" + name + "\"};\n";
+    }
+  }
+  for(const auto& [text, name] : strings) {
+    program += "const lox::Value " + name + " = lox::string(" + quote(text) + ");\n";
+  }
+  for(const std::string& name : properties) {
+    program += "const std::string p_" + name + " = \"" + name + "\";\n";
+  }
+  program += "\n" + prototypes + "\n" + definitions;
+  program += "void script() {\n" + body + "}\n\n}\n\nint main() {\n  return lox::run(script);\n}\n";
+  return program;
+}
+
+void CppEmitter::run(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  for(const std::shared_ptr<Stmt>& stmt : statements) {
+    emit(stmt);
+  }
+}
+
+void CppEmitter::emit(const std::shared_ptr<Stmt>& stmt) {
+  stmt->accept(*this);
+}
+
+void CppEmitter::emitNested(const std::shared_ptr<Stmt>& stmt) {
+  indent++;
+  if(auto block = std::dynamic_pointer_cast<Block>(stmt)) {
+    beginScope();
+    run(block->statements);
+    endScope();
+  } else {
+    emit(stmt);
+  }
+  indent--;
+}
+
+std::string CppEmitter::emit(const std::shared_ptr<Expr>& expr) {
+  return std::any_cast<std::string>(expr->accept(*this));
+}
+
+std::string CppEmitter::condition(const std::shared_ptr<Expr>& expr) {
+  // Only the truthiness of a condition matters, so `and`, `or` and `!`
+  // become their C++ counterparts instead of producing a value.
+  if(auto logical = std::dynamic_pointer_cast<Logical>(expr)) {
+    std::string op = logical->op.type == TokenType::OR ? " || " : " && ";
+    return "(" + condition(logical->left) + op + condition(logical->right) + ")";
+  }
+  if(auto unary = std::dynamic_pointer_cast<Unary>(expr)) {
+    if(unary->op.type == TokenType::BANG) return "!" + condition(unary->right);
+  }
+  if(auto grouping = std::dynamic_pointer_cast<Grouping>(expr)) {
+    return condition(grouping->expression);
+  }
+  return emit(expr) + ".truthy()";
+}
+
+void CppEmitter::line(const std::string& code) {
+  body.append(2 * indent, ' ');
+  body += code;
+  body += '\n';
+}
+
+void CppEmitter::beginScope() {
+  scopes.push_back(Scope{{}, static_cast<int>(functions.size())});
+}
+
+void CppEmitter::endScope() {
+  scopes.pop_back();
+}
+
+void CppEmitter::define(Slot slot, const std::string& name, const std::string& value) {
+  if(scopes.empty()) {
+    if(collecting) definedGlobals.insert(name);
+    globalNames.insert(name);
+    line("g_" + name + ".define(" + value + ");");
+    return;
+  }
+  scopes.back().names[name] = slot;
+  std::string cppName = "l" + std::to_string(counter++) + "_" + name;
+  locals[slot] = cppName;
+  if(boxed.count(slot)) {
+    line("lox::Ref<lox::Cell> c_" + cppName + " = lox::cell(" + value + ");");
+    line("lox::Value& " + cppName + " = c_" + cppName + "->value;");
+  } else {
+    line("lox::Value " + cppName + " = " + value + ";");
+  }
+}
+
+std::string CppEmitter::local(const std::string& name, int depth) {
+  int index = static_cast<int>(scopes.size()) - 1 - depth;
+  if(index < 0) return "lox::Value()";
+  const Scope& scope = scopes[index];
+  auto slot = scope.names.find(name);
+  if(slot == scope.names.end()) return "lox::Value()";
+  if(collecting && scope.function < static_cast<int>(functions.size())) {
+    boxed.insert(slot->second);
+    for(size_t i = scope.function; i < functions.size(); i++) {
+      std::vector<Slot>& captured = captures[functions[i]];
+      if(std::find(captured.begin(), captured.end(), slot->second) == captured.end()) {
+        captured.push_back(slot->second);
+      }
+    }
+  }
+  return locals[slot->second];
+}
+
+std::string CppEmitter::global(const Token& name) {
+  const std::string& lexeme = name.lexeme;
+  if(lexeme != "clock" && !definedGlobals.count(lexeme)) {
+    std::any* value = globals.find(lexeme);
+    if(value != nullptr && value->type() == typeid(std::shared_ptr<LoxNative>)) {
+      unsupported(name, "Native '" + lexeme + "' is not available in C++ output.");
+    }
+  }
+  globalNames.insert(lexeme);
+  return "g_" + lexeme;
+}
+
+std::string CppEmitter::property(const std::string& name) {
+  properties.insert(name);
+  return "p_" + name;
+}
+
+void CppEmitter::unsupported(const Token& token, const std::string& message) {
+  if(!collecting) lox.error(token, message);
+}
+
+std::string CppEmitter::emitFunction(Function& function, bool method) {
+  std::string name = "f" + std::to_string(counter++) + "_" + function.name.lexeme;
+  bool isInitializer = method && function.name.lexeme == "init";
+  std::string enclosingBody = std::move(body);
+  int enclosingIndent = indent;
+  bool enclosingInitializer = initializer;
+  body.clear();
+  indent = 1;
+  initializer = isInitializer;
+
+  // The cells this function was created with, under the names they have
+  // in the enclosing function.
+  const std::vector<Slot>& captured = captures[&function];
+  for(size_t i = 0; i < captured.size(); i++) {
+    const std::string& cppName = locals[captured[i]];
+    line("lox::Ref<lox::Cell>& c_" + cppName + " = self.captures[" + std::to_string(i) + "];");
+    line("lox::Value& " + cppName + " = c_" + cppName + "->value;");
+  }
+  functions.push_back(&function);
+  if(method) {
+    beginScope();
+    define(&function.name, "this", "receiver");
+  }
+  beginScope();
+  for(size_t i = 0; i < function.params.size(); i++) {
+    define(&function.params[i], function.params[i].lexeme, "arguments[" + std::to_string(i) + "]");
+  }
+  run(function.body);
+  line(isInitializer ? "return receiver;" : "return lox::Value();");
+  endScope();
+  if(method) endScope();
+  functions.pop_back();
+
+  std::string signature = "lox::Value " + name + "(lox::Function& self, const lox::Value& receiver, const lox::Value* arguments)";
+  prototypes += signature + ";\n";
+  definitions += signature + " {\n" + body + "}\n\n";
+  body = std::move(enclosingBody);
+  indent = enclosingIndent;
+  initializer = enclosingInitializer;
+
+  std::string cells;
+  for(Slot slot : captured) {
+    if(!cells.empty()) cells += ", ";
+    cells += "c_" + locals[slot];
+  }
+  return "lox::function(" + quote(function.name.lexeme) + ", " + std::to_string(function.params.size()) + ", " + name +
+    ", {" + cells + "}" + (isInitializer ? ", true" : "") + ")";
+}
+
+std::any CppEmitter::visitBlockStmt(Block& stmt) {
+  line("{");
+  indent++;
+  beginScope();
+  run(stmt.statements);
+  endScope();
+  indent--;
+  line("}");
+  return {};
+}
+
+std::any CppEmitter::visitExpressionStmt(Expression& stmt) {
+  line(emit(stmt.expression) + ";");
+  return {};
+}
+
+std::any CppEmitter::visitFunctionStmt(Function& stmt) {
+  if(scopes.empty()) {
+    define(&stmt.name, stmt.name.lexeme, emitFunction(stmt, false));
+    return {};
+  }
+  // A local is declared before the body is emitted so the function can
+  // capture it and call itself.
+  define(&stmt.name, stmt.name.lexeme, "lox::Value()");
+  std::string closure = emitFunction(stmt, false);
+  line(locals[&stmt.name] + " = " + closure + ";");
+  return {};
+}
+
+std::any CppEmitter::visitIfStmt(If& stmt) {
+  line("if(" + condition(stmt.condition) + ") {");
+  emitNested(stmt.thenBranch);
+  if(stmt.elseBranch != nullptr) {
+    line("} else {");
+    emitNested(stmt.elseBranch);
+  }
+  line("}");
+  return {};
+}
+
+std::any CppEmitter::visitPrintStmt(Print& stmt) {
+  line("lox::print(" + emit(stmt.expression) + ");");
+  return {};
+}
+
+std::any CppEmitter::visitClassStmt(Class& stmt) {
+  std::string superclass = "lox::Value()";
+  if(stmt.superclass != nullptr) superclass = emit(stmt.superclass);
+  int superclassLine = stmt.superclass != nullptr ? stmt.superclass->name.line : stmt.name.line;
+  define(&stmt.name, stmt.name.lexeme, "lox::Value()");
+  std::string target = scopes.empty() ? "g_" + stmt.name.lexeme + ".define(" : locals[&stmt.name] + " = (";
+
+  line("{");
+  indent++;
+  if(stmt.superclass != nullptr) {
+    beginScope();
+    define(&stmt.superclass->name, "super", superclass);
+    superclass = locals[&stmt.superclass->name];
+  }
+  std::string methods;
+  for(const std::shared_ptr<Function>& method : stmt.methods) {
+    if(!methods.empty()) methods += ", ";
+    methods += "{" + quote(method->name.lexeme) + ", " + emitFunction(*method, true) + "}";
+  }
+  if(stmt.superclass != nullptr) endScope();
+  line(target + "lox::makeClass(" + quote(stmt.name.lexeme) + ", " + superclass + ", " + std::to_string(superclassLine) + ", {" + methods + "}));");
+  indent--;
+  line("}");
+  return {};
+}
+
+std::any CppEmitter::visitReturnStmt(Return& stmt) {
+  if(initializer) {
+    line("return receiver;");
+  } else if(stmt.value == nullptr) {
+    line("return lox::Value();");
+  } else {
+    line("return " + emit(stmt.value) + ";");
+  }
+  return {};
+}
+
+std::any CppEmitter::visitVarStmt(Var& stmt) {
+  std::string value = "lox::Value()";
+  if(stmt.initializer != nullptr) value = emit(stmt.initializer);
+  define(&stmt.name, stmt.name.lexeme, value);
+  return {};
+}
+
+std::any CppEmitter::visitWhileStmt(While& stmt) {
+  line("while(" + condition(stmt.condition) + ") {");
+  emitNested(stmt.body);
+  line("}");
+  return {};
+}
+
+std::any CppEmitter::visitForStmt(For& stmt) {
+  if(stmt.initializer != nullptr) {
+    line("{");
+    indent++;
+    beginScope();
+    emit(stmt.initializer);
+  }
+  line("while(" + condition(stmt.condition) + ") {");
+  emitNested(stmt.body);
+  if(stmt.increment != nullptr) {
+    indent++;
+    line(emit(stmt.increment) + ";");
+    indent--;
+  }
+  line("}");
+  if(stmt.initializer != nullptr) {
+    endScope();
+    indent--;
+    line("}");
+  }
+  return {};
+}
+
+std::any CppEmitter::visitAssignExpr(Assign& expr) {
+  std::string value = emit(expr.value);
+  if(expr.depth < 0) {
+    return global(expr.name) + ".assign(" + value + ", " + std::to_string(expr.name.line) + ")";
+  }
+  return "(" + local(expr.name.lexeme, expr.depth) + " = " + value + ")";
+}
+
+std::any CppEmitter::visitBinaryExpr(Binary& expr) {
+  std::string left = emit(expr.left);
+  std::string right = emit(expr.right);
+  std::string line = std::to_string(expr.op.line);
+  switch(expr.op.type) {
+    case TokenType::BANG_EQUAL: return "lox::Value(!" + left + ".equals(" + right + "))";
+    case TokenType::EQUAL_EQUAL: return "lox::Value(" + left + ".equals(" + right + "))";
+    case TokenType::GREATER: return left + ".greater(" + right + ", " + line + ")";
+    case TokenType::GREATER_EQUAL: return left + ".greaterEqual(" + right + ", " + line + ")";
+    case TokenType::LESS: return left + ".less(" + right + ", " + line + ")";
+    case TokenType::LESS_EQUAL: return left + ".lessEqual(" + right + ", " + line + ")";
+    case TokenType::MINUS: return left + ".subtract(" + right + ", " + line + ")";
+    case TokenType::PLUS: return left + ".add(" + right + ", " + line + ")";
+    case TokenType::SLASH: return left + ".divide(" + right + ", " + line + ")";
+    case TokenType::STAR: return left + ".multiply(" + right + ", " + line + ")";
+  }
+  return std::string("lox::Value()");
+}
+
+std::any CppEmitter::visitCallExpr(Call& expr) {
+  std::string callee;
+  if(auto get = std::dynamic_pointer_cast<Get>(expr.callee)) {
+    callee = emit(get->object) + ".invoke(" + property(get->name.lexeme) + ", " + std::to_string(get->name.line) + ")";
+  } else {
+    callee = emit(expr.callee);
+  }
+  std::string arguments;
+  for(const std::shared_ptr<Expr>& argument : expr.arguments) {
+    if(!arguments.empty()) arguments += ", ";
+    arguments += emit(argument);
+  }
+  return callee + ".call({" + arguments + "}, " + std::to_string(expr.paren.line) + ")";
+}
+
+std::any CppEmitter::visitGroupingExpr(Grouping& expr) {
+  return emit(expr.expression);
+}
+
+std::any CppEmitter::visitLiteralExpr(Literal& expr) {
+  const std::any& value = expr.value;
+  if(value.type() == typeid(double)) return "lox::Value(" + number(std::any_cast<double>(value)) + ")";
+  if(value.type() == typeid(bool)) return std::string(std::any_cast<bool>(value) ? "lox::Value(true)" : "lox::Value(false)");
+  if(value.type() == typeid(std::shared_ptr<LoxString>)) {
+    const std::string& text = std::any_cast<const std::shared_ptr<LoxString>&>(value)->str();
+    auto constant = strings.find(text);
+    if(constant == strings.end()) {
+      constant = strings.emplace(text, "s" + std::to_string(strings.size())).first;
+    }
+    return constant->second;
+  }
+  return std::string("lox::Value()");
+}
+
+std::any CppEmitter::visitLogicalExpr(Logical& expr) {
+  std::string left = emit(expr.left);
+  std::string right = emit(expr.right);
+  std::string test = expr.op.type == TokenType::OR ? "left.truthy()" : "!left.truthy()";
+  return "[&]() -> lox::Value { lox::Value left = " + left + "; if(" + test + ") return left; return " + right + "; }()";
+}
+
+std::any CppEmitter::visitUnaryExpr(Unary& expr) {
+  std::string right = emit(expr.right);
+  if(expr.op.type == TokenType::BANG) return "lox::Value(!" + right + ".truthy())";
+  return right + ".negate(" + std::to_string(expr.op.line) + ")";
+}
+
+std::any CppEmitter::visitGetExpr(Get& expr) {
+  return emit(expr.object) + ".get(" + property(expr.name.lexeme) + ", " + std::to_string(expr.name.line) + ")";
+}
+
+std::any CppEmitter::visitSetExpr(Set& expr) {
+  std::string object = emit(expr.object);
+  return "lox::fields(" + object + ", " + std::to_string(expr.name.line) + ").set(" + property(expr.name.lexeme) + ", " + emit(expr.value) + ")";
+}
+
+std::any CppEmitter::visitThisExpr(This& expr) {
+  return local("this", expr.depth);
+}
+
+std::any CppEmitter::visitSuperExpr(Super& expr) {
+  std::string superclass = local("super", expr.depth);
+  std::string receiver = local("this", expr.depth - 1);
+  return "lox::superMethod(" + superclass + ", " + receiver + ", " + property(expr.method.lexeme) + ", " + std::to_string(expr.method.line) + ")";
+}
+
+std::any CppEmitter::visitVariableExpr(Variable& expr) {
+  if(expr.depth < 0) return global(expr.name) + ".get(" + std::to_string(expr.name.line) + ")";
+  return local(expr.name.lexeme, expr.depth);
+}
+
+std::any CppEmitter::visitIndexExpr(Index& expr) {
+  emit(expr.object);
+  emit(expr.index);
+  unsupported(expr.bracket, "Indexing is not available in C++ output.");
+  return std::string("lox::Value()");
+}
+
+std::any CppEmitter::visitSetIndexExpr(SetIndex& expr) {
+  emit(expr.object);
+  emit(expr.index);
+  emit(expr.value);
+  unsupported(expr.bracket, "Indexing is not available in C++ output.");
+  return std::string("lox::Value()");
+}
+
+std::any CppEmitter::visitListLiteralExpr(ListLiteral& expr) {
+  for(const std::shared_ptr<Expr>& element : expr.elements) {
+    emit(element);
+  }
+  unsupported(expr.bracket, "Lists are not available in C++ output.");
+  return std::string("lox::Value()");
+}
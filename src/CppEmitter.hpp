@@ -0,0 +1,116 @@
+#ifndef __CPPEMITTER_H
+#define __CPPEMITTER_H
+
+#include <any>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+class Environment;
+class Lox;
+
+// Translates a resolved script into a standalone C++ program for
+// --emit-cpp. The program links against src/runtime (see LoxRuntime.hpp)
+// and behaves like the interpreter, error messages included.
+//
+// Every Lox function becomes a C++ function and every local a C++
+// local. Locals that closures use live in a shared Cell instead, which
+// the closure receives when it is created. A first walk over the script
+// finds those locals and what each function captures; the second writes
+// the code. Lists, maps and natives other than clock are reported as
+// errors because the runtime does not have them.
+class CppEmitter : public ExprVisitor, public StmtVisitor {
+  Lox& lox;
+  Environment& globals;
+
+  // Locals are identified by the token that declares them. The receiver
+  // of a method is keyed by the method's name token, and the superclass
+  // of a class by its Variable's name token.
+  using Slot = const Token*;
+  struct Scope {
+    std::map<std::string, Slot> names;
+    int function;
+  };
+  std::vector<Scope> scopes;
+  std::vector<const Function*> functions;
+
+  bool collecting = false;
+  // Locals used by functions nested in the one that declares them.
+  std::set<Slot> boxed;
+  // The locals of enclosing functions that each function uses, directly
+  // or through the functions nested in it, in the order it receives them.
+  std::map<const Function*, std::vector<Slot>> captures;
+  std::set<std::string> definedGlobals;
+
+  // C++ names of the locals, globals, string constants and property
+  // names the generated code uses.
+  std::map<Slot, std::string> locals;
+  std::set<std::string> globalNames;
+  std::map<std::string, std::string> strings;
+  std::set<std::string> properties;
+  int counter = 0;
+
+  std::string prototypes;
+  std::string definitions;
+  // The C++ function being written.
+  std::string body;
+  int indent = 1;
+  bool initializer = false;
+
+  void run(const std::vector<std::shared_ptr<Stmt>>& statements);
+  void emit(const std::shared_ptr<Stmt>& stmt);
+  // Emits a statement that is the body of an if or a loop as a block.
+  void emitNested(const std::shared_ptr<Stmt>& stmt);
+  std::string emit(const std::shared_ptr<Expr>& expr);
+  // A C++ condition for the truthiness of `expr`.
+  std::string condition(const std::shared_ptr<Expr>& expr);
+  std::string emitFunction(Function& function, bool method);
+  void line(const std::string& code);
+  void beginScope();
+  void endScope();
+  void define(Slot slot, const std::string& name, const std::string& value);
+  std::string local(const std::string& name, int depth);
+  std::string global(const Token& name);
+  std::string property(const std::string& name);
+  void unsupported(const Token& token, const std::string& message);
+
+public:
+  CppEmitter(Lox& lox, Environment& globals)
+    : lox{lox}, globals{globals} {}
+
+  // Returns the program's source. Errors are reported to `lox`.
+  std::string emit(const std::vector<std::shared_ptr<Stmt>>& statements, const std::string& fileName);
+
+  std::any visitBlockStmt(Block& stmt) override;
+  std::any visitExpressionStmt(Expression& stmt) override;
+  std::any visitFunctionStmt(Function& stmt) override;
+  std::any visitIfStmt(If& stmt) override;
+  std::any visitPrintStmt(Print& stmt) override;
+  std::any visitClassStmt(Class& stmt) override;
+  std::any visitReturnStmt(Return& stmt) override;
+  std::any visitVarStmt(Var& stmt) override;
+  std::any visitWhileStmt(While& stmt) override;
+  std::any visitForStmt(For& stmt) override;
+
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
+};
+
+#endif
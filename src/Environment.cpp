@@ -6,17 +6,24 @@ void Environment::define(const std::string& name, std::any value) {
 }
 
 std::any Environment::get(const Token& name) {
-  auto elem = values.find(name.lexeme);
-  if(elem != values.end()) 
-    return elem->second;
+  if(std::any* value = find(name.lexeme)) return *value;
   if(enclosing != nullptr) return enclosing->get(name);
   throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
 }
 
+std::any* Environment::find(const std::string& name) {
+  if(parameters != nullptr) {
+    for(size_t i = 0; i < parameters->size(); i++) {
+      if((*parameters)[i].lexeme == name) return &arguments[i];
+    }
+  }
+  auto elem = values.find(name);
+  return elem != values.end() ? &elem->second : nullptr;
+}
+
 void Environment::assign(const Token& name, std::any value) {
-  auto elem = values.find(name.lexeme);
-  if(elem != values.end()) {
-    elem->second = value;
+  if(std::any* slot = find(name.lexeme)) {
+    *slot = std::move(value);
     return;
   }
   if(enclosing != nullptr) {
@@ -26,18 +33,22 @@ void Environment::assign(const Token& name, std::any value) {
   throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
 }
 
-std::shared_ptr<Environment> Environment::ancestor(int distance) {
-  std::shared_ptr<Environment> environment = shared_from_this();
+Environment* Environment::ancestor(int distance) {
+  Environment* environment = this;
   for(int i = 0; i < distance; i++) {
-    environment = environment->enclosing;
+    environment = environment->enclosing.get();
   }
   return environment;
 }
 
 std::any Environment::getAt(int distance, const std::string& name) {
-  return ancestor(distance)->values[name];
+  // Lookups must not insert: worker threads read shared environments.
+  std::any* value = ancestor(distance)->find(name);
+  return value != nullptr ? *value : std::any{};
 }
 
 void Environment::assignAt(int distance, const Token& name, std::any& value) {
-  ancestor(distance)->values[name.lexeme] = value;
+  Environment* environment = ancestor(distance);
+  if(std::any* slot = environment->find(name.lexeme)) *slot = value;
+  else environment->values[name.lexeme] = value;
 }
\ No newline at end of file
@@ -4,19 +4,28 @@
 #include <map>
 #include <any>
 #include <memory>
+#include <span>
+#include <vector>
 #include "Token.hpp"
 
-class Environment : public std::enable_shared_from_this<Environment> {
+class Environment {
   friend class Interpreter;
+  friend class AstStats;
 
   std::shared_ptr<Environment> enclosing;
   std::map<std::string, std::any> values;
+  // A call's parameters, when LoxFunction::call leaves them in the
+  // caller's arguments instead of copying them into `values`.
+  const std::vector<Token>* parameters = nullptr;
+  std::any* arguments = nullptr;
 public:
 // Constructors
   Environment() 
     : values{}, enclosing{nullptr} {}
   Environment(std::shared_ptr<Environment> enclosing)
     : values{}, enclosing{std::move(enclosing)} {}
+  Environment(std::shared_ptr<Environment> enclosing, const std::vector<Token>& parameters, std::span<std::any> arguments)
+    : values{}, enclosing{std::move(enclosing)}, parameters{&parameters}, arguments{arguments.data()} {}
   ~Environment() = default;
   Environment(Environment& other) = delete;
   Environment(Environment&& other) = delete;
@@ -25,9 +34,13 @@ public:
 // Methods
   void define(const std::string& name, std::any value);
   std::any get(const Token& name);
+  // Looks the name up in this environment only; nullptr if it is not
+  // defined. Variables are never removed, so the cell stays valid for as
+  // long as the environment does (for a parameter, as long as the call).
+  std::any* find(const std::string& name);
   void assign(const Token& name, std::any value);
   std::any getAt(int distance, const std::string& name);
-  std::shared_ptr<Environment> ancestor(int distance);
+  Environment* ancestor(int distance);
   void assignAt(int distance, const Token& name, std::any& value);
 };
 
@@ -0,0 +1,310 @@
+#include "EventLoop.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "Interpreter.hpp"
+#include "LoxFunction.hpp"
+#include "LoxNative.hpp"
+#include "LoxString.hpp"
+#include "Environment.hpp"
+
+static int64_t now() {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec * 1000000000ll + time.tv_nsec;
+}
+
+EventLoop::EventLoop(Interpreter& interpreter)
+  : interpreter{interpreter} {
+  epoll = epoll_create1(EPOLL_CLOEXEC);
+  timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if(epoll < 0 || timer < 0) throw NativeError("Cannot create the event loop.");
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.ptr = nullptr;
+  epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &event);
+}
+
+EventLoop::~EventLoop() {
+  // Tasks still blocked here never finish; their stacks are unmapped
+  // without unwinding them.
+  for(auto& [task, owner] : live) releaseStack(*task);
+  for(char* stack : freeStacks) munmap(stack, stackSize);
+  close(timer);
+  close(epoll);
+}
+
+void EventLoop::entry(uint32_t high, uint32_t low) {
+  EventLoop& loop = *reinterpret_cast<EventLoop*>(static_cast<uintptr_t>(high) << 32 | low);
+  LoxTask& task = *loop.current;
+  try {
+    task.result = task.function->call(loop.interpreter, {});
+  } catch(...) {
+    // Rethrown on the main stack by resume().
+    task.error = std::current_exception();
+  }
+  task.done = true;
+  for(LoxTask* waiter : task.waiters) loop.wake(waiter);
+  task.waiters.clear();
+  // Returning continues at uc_link, the scheduler.
+}
+
+std::shared_ptr<LoxTask> EventLoop::spawn(std::shared_ptr<LoxFunction> function) {
+  auto task = std::make_shared<LoxTask>();
+  task->function = std::move(function);
+  task->environment = interpreter.globals;
+  if(!freeStacks.empty()) {
+    task->stack = freeStacks.back();
+    freeStacks.pop_back();
+  } else {
+    void* stack = mmap(nullptr, stackSize, PROT_READ | PROT_WRITE, 
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if(stack == MAP_FAILED) throw NativeError("Cannot allocate a task stack.");
+    // Guard page: overflowing the stack faults instead of corrupting memory.
+    mprotect(stack, sysconf(_SC_PAGESIZE), PROT_NONE);
+    task->stack = static_cast<char*>(stack);
+  }
+  getcontext(&task->context);
+  task->context.uc_stack.ss_sp = task->stack;
+  task->context.uc_stack.ss_size = stackSize;
+  task->context.uc_link = &scheduler;
+  uintptr_t self = reinterpret_cast<uintptr_t>(this);
+  makecontext(&task->context, reinterpret_cast<void(*)()>(&EventLoop::entry), 2, 
+    static_cast<uint32_t>(self >> 32), static_cast<uint32_t>(self));
+  live[task.get()] = task;
+  ready.push_back(task.get());
+  return task;
+}
+
+void EventLoop::releaseStack(LoxTask& task) {
+  if(task.stack == nullptr) return;
+  if(freeStacks.size() < maxCachedStacks) freeStacks.push_back(task.stack);
+  else munmap(task.stack, stackSize);
+  task.stack = nullptr;
+}
+
+void EventLoop::wake(LoxTask* task) {
+  if(task == &mainTask) mainTask.woken = true;
+  else ready.push_back(task);
+}
+
+void EventLoop::resume(LoxTask* task) {
+  std::shared_ptr<Environment> mainEnvironment = interpreter.environment;
+  interpreter.environment = task->environment;
+  current = task;
+  swapcontext(&scheduler, &task->context);
+  current = &mainTask;
+  task->environment = interpreter.environment;
+  interpreter.environment = mainEnvironment;
+
+  if(task->done) {
+    task->environment = nullptr;
+    releaseStack(*task);
+    std::shared_ptr<LoxTask> owner = std::move(live[task]);
+    live.erase(task);
+    if(owner->error) std::rethrow_exception(owner->error);
+  }
+}
+
+void EventLoop::block() {
+  if(current != &mainTask) {
+    // The scheduler restores the interpreter state when it resumes us.
+    swapcontext(&current->context, &scheduler);
+    return;
+  }
+  while(!mainTask.woken) {
+    if(!step(true)) throw NativeError("Deadlock: no task can make progress.");
+  }
+  mainTask.woken = false;
+}
+
+bool EventLoop::step(bool wait) {
+  if(!ready.empty()) {
+    LoxTask* task = ready.front();
+    ready.pop_front();
+    resume(task);
+    return true;
+  }
+  if(timers.empty() && watching == 0) return false;
+  if(!wait) return true;
+
+  epoll_event events[64];
+  int count = epoll_wait(epoll, events, 64, -1);
+  if(count < 0 && errno != EINTR) throw NativeError(std::string("epoll_wait failed: ") + std::strerror(errno));
+  for(int i = 0; i < count; i++) {
+    if(events[i].data.ptr == nullptr) expireTimers();
+    else wake(static_cast<LoxTask*>(events[i].data.ptr));
+  }
+  return true;
+}
+
+void EventLoop::armTimer() {
+  int64_t deadline = timers.empty() ? 0 : timers.top().deadline;
+  if(deadline == armedDeadline) return;
+  armedDeadline = deadline;
+  itimerspec spec{};
+  // A zero it_value disarms the timer.
+  spec.it_value.tv_sec = deadline / 1000000000;
+  spec.it_value.tv_nsec = deadline % 1000000000;
+  timerfd_settime(timer, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void EventLoop::expireTimers() {
+  uint64_t expirations;
+  while(read(timer, &expirations, sizeof(expirations)) > 0) {}
+  int64_t time = now();
+  while(!timers.empty() && timers.top().deadline <= time) {
+    wake(timers.top().task);
+    timers.pop();
+  }
+  armedDeadline = 0;
+  armTimer();
+}
+
+void EventLoop::yield() {
+  if(current != &mainTask) {
+    wake(current);
+    block();
+    return;
+  }
+  // The main script lets every task that is ready right now run once.
+  epoll_event events[64];
+  int count = epoll_wait(epoll, events, 64, 0);
+  for(int i = 0; i < count; i++) {
+    if(events[i].data.ptr == nullptr) expireTimers();
+    else wake(static_cast<LoxTask*>(events[i].data.ptr));
+  }
+  for(size_t n = ready.size(); n > 0 && !ready.empty(); n--) step(false);
+}
+
+void EventLoop::sleep(double seconds) {
+  int64_t deadline = now() + static_cast<int64_t>(std::max(seconds, 0.0) * 1e9);
+  timers.push(Timer{std::max<int64_t>(deadline, 1), timerCount++, current});
+  armTimer();
+  block();
+}
+
+std::any EventLoop::await(const std::shared_ptr<LoxTask>& task) {
+  if(task.get() == current) throw NativeError("A task cannot await itself.");
+  if(!task->done) {
+    task->waiters.push_back(current);
+    block();
+  }
+  return task->result;
+}
+
+void EventLoop::waitReadable(int fd) {
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLONESHOT;
+  event.data.ptr = current;
+  if(epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+    // Regular files cannot be polled and are always readable.
+    if(errno == EPERM) return;
+    throw NativeError(std::string("Cannot wait for handle: ") + std::strerror(errno));
+  }
+  watching++;
+  try {
+    block();
+  } catch(...) {
+    watching--;
+    epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+    throw;
+  }
+  watching--;
+  epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EventLoop::drain() {
+  while(step(true)) {}
+}
+
+static std::shared_ptr<LoxTask> asTask(std::any& value, const std::string& function) {
+  if(value.type() != typeid(std::shared_ptr<LoxTask>)) {
+    throw NativeError("Argument to '" + function + "' must be a task.");
+  }
+  return std::any_cast<std::shared_ptr<LoxTask>>(value);
+}
+
+static int asHandle(std::any& value, const std::string& function) {
+  if(value.type() != typeid(double) || std::floor(std::any_cast<double>(value)) != std::any_cast<double>(value)) {
+    throw NativeError("Argument to '" + function + "' must be a handle returned by 'open'.");
+  }
+  return static_cast<int>(std::any_cast<double>(value));
+}
+
+void EventLoop::defineNatives(Environment& globals) {
+  globals.define("spawnTask", std::make_shared<LoxNative>("spawnTask", 1,
+    [](Interpreter& interpreter, std::span<std::any> arguments) -> std::any {
+      if(arguments[0].type() != typeid(std::shared_ptr<LoxFunction>)) {
+        throw NativeError("Argument to 'spawnTask' must be a function.");
+      }
+      auto function = std::any_cast<std::shared_ptr<LoxFunction>>(arguments[0]);
+      if(function->arity() != 0) throw NativeError("Function passed to 'spawnTask' must take no arguments.");
+      return interpreter.eventLoop().spawn(function);
+    }));
+
+  globals.define("yield", std::make_shared<LoxNative>("yield", 0,
+    [](Interpreter& interpreter, std::span<std::any>) -> std::any {
+      interpreter.eventLoop().yield();
+      return nullptr;
+    }));
+
+  globals.define("sleep", std::make_shared<LoxNative>("sleep", 1,
+    [](Interpreter& interpreter, std::span<std::any> arguments) -> std::any {
+      if(arguments[0].type() != typeid(double)) throw NativeError("Argument to 'sleep' must be a number.");
+      interpreter.eventLoop().sleep(std::any_cast<double>(arguments[0]));
+      return nullptr;
+    }));
+
+  globals.define("await", std::make_shared<LoxNative>("await", 1,
+    [](Interpreter& interpreter, std::span<std::any> arguments) -> std::any {
+      return interpreter.eventLoop().await(asTask(arguments[0], "await"));
+    }));
+
+  // Handles are opened non-blocking: a read that would block suspends the
+  // calling task and lets the others run.
+  globals.define("open", std::make_shared<LoxNative>("open", 1,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      if(arguments[0].type() != typeid(std::shared_ptr<LoxString>)) {
+        throw NativeError("Argument to 'open' must be a path.");
+      }
+      const std::string& path = std::any_cast<std::shared_ptr<LoxString>&>(arguments[0])->str();
+      int fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+      if(fd < 0) throw NativeError("Cannot open '" + path + "': " + std::strerror(errno) + ".");
+      return static_cast<double>(fd);
+    }));
+
+  // Returns the next chunk of input as a string, or nil at end of input.
+  globals.define("read", std::make_shared<LoxNative>("read", 1,
+    [](Interpreter& interpreter, std::span<std::any> arguments) -> std::any {
+      int fd = asHandle(arguments[0], "read");
+      // On the heap: this may run on a small task stack.
+      std::string chunk(1 << 16, '\0');
+      while(true) {
+        ssize_t count = ::read(fd, chunk.data(), chunk.size());
+        if(count > 0) {
+          chunk.resize(count);
+          return std::make_shared<LoxString>(std::move(chunk));
+        }
+        if(count == 0) return nullptr;
+        if(errno == EAGAIN || errno == EWOULDBLOCK) interpreter.eventLoop().waitReadable(fd);
+        else if(errno != EINTR) throw NativeError(std::string("Read failed: ") + std::strerror(errno) + ".");
+      }
+    }));
+
+  globals.define("close", std::make_shared<LoxNative>("close", 1,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      ::close(asHandle(arguments[0], "close"));
+      return nullptr;
+    }));
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef __EVENTLOOP_H
+#define __EVENTLOOP_H
+
+#include <any>
+#include <memory>
+
+class Environment;
+class Interpreter;
+
+#ifdef __linux__
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include <ucontext.h>
+
+class LoxFunction;
+
+// A function started with spawnTask. It runs on its own small stack so it
+// can be suspended in the middle of any Lox call and resumed later.
+class LoxTask {
+  friend class EventLoop;
+
+  ucontext_t context;
+  char* stack = nullptr;
+  std::shared_ptr<LoxFunction> function;
+  // The interpreter's current environment while the task is suspended.
+  std::shared_ptr<Environment> environment;
+  std::vector<LoxTask*> waiters;
+  std::exception_ptr error;
+  bool woken = false;
+public:
+  std::any result = nullptr;
+  bool done = false;
+};
+
+// Single-threaded scheduler for Lox tasks, one per interpreter. The main
+// script runs on the thread's own stack and drives the loop whenever it
+// waits (await, sleep, yield, a read that would block) and after the
+// script ends. Tasks switch with swapcontext; blocked tasks are woken by
+// epoll, and timers share one timerfd armed for the earliest deadline.
+//
+// Task stacks are 256 KiB of address space each, of which only the pages
+// a task touches are ever backed by memory: a task suspended a few calls
+// deep costs about 6 KiB in total. Finished stacks are reused.
+class EventLoop {
+  static constexpr size_t stackSize = 256 * 1024;
+  static constexpr size_t maxCachedStacks = 64;
+
+  Interpreter& interpreter;
+  int epoll;
+  int timer;
+  ucontext_t scheduler;
+  // Stands in for the main script in wait lists; it has no stack.
+  LoxTask mainTask;
+  LoxTask* current = &mainTask;
+  std::deque<LoxTask*> ready;
+  // Owns every unfinished task, so a task whose handle the script drops
+  // still runs to completion.
+  std::unordered_map<LoxTask*, std::shared_ptr<LoxTask>> live;
+  struct Timer {
+    int64_t deadline;
+    uint64_t order;
+    LoxTask* task;
+    bool operator>(const Timer& other) const {
+      return deadline != other.deadline ? deadline > other.deadline : order > other.order;
+    }
+  };
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+  uint64_t timerCount = 0;
+  int64_t armedDeadline = 0;
+  size_t watching = 0;
+  std::vector<char*> freeStacks;
+
+  static void entry(uint32_t high, uint32_t low);
+  void wake(LoxTask* task);
+  void block();
+  bool step(bool wait);
+  void resume(LoxTask* task);
+  void armTimer();
+  void expireTimers();
+  void releaseStack(LoxTask& task);
+public:
+  EventLoop(Interpreter& interpreter);
+  ~EventLoop();
+  EventLoop(EventLoop& other) = delete;
+  EventLoop& operator=(EventLoop& other) = delete;
+
+  std::shared_ptr<LoxTask> spawn(std::shared_ptr<LoxFunction> function);
+  void yield();
+  void sleep(double seconds);
+  std::any await(const std::shared_ptr<LoxTask>& task);
+  // Suspends the current task until fd is readable.
+  void waitReadable(int fd);
+  // Runs tasks until none can make progress.
+  void drain();
+
+  static void defineNatives(Environment& globals);
+};
+
+#else
+
+// Tasks need ucontext and epoll; elsewhere the natives are not defined.
+class EventLoop {
+public:
+  EventLoop(Interpreter&) {}
+  void drain() {}
+  static void defineNatives(Environment&) {}
+};
+
+#endif
+
+#endif
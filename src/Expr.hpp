@@ -2,6 +2,7 @@
 #define __EXPR_H
 
 #include <any>
+#include <cstdint>
 #include <memory>
 #include <utility>  // std::move
 #include <vector>
@@ -20,20 +21,29 @@ struct This;
 struct Unary;
 struct Variable;
 struct Logical;
+struct Index;
+struct SetIndex;
+struct ListLiteral;
 
+// Visitors get nodes by reference. Nodes are owned by the statement list
+// of the program being run, or by the LoxFunctions declared in it, for as
+// long as they can be visited, so visiting never touches a reference count.
 struct ExprVisitor {
-  virtual std::any visitAssignExpr(std::shared_ptr<Assign> expr) = 0;
-  virtual std::any visitBinaryExpr(std::shared_ptr<Binary> expr) = 0;
-  virtual std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) = 0;
-  virtual std::any visitLiteralExpr(std::shared_ptr<Literal> expr) = 0;
-  virtual std::any visitGetExpr(std::shared_ptr<Get> expr) = 0;
-  virtual std::any visitSetExpr(std::shared_ptr<Set> expr) = 0;
-  virtual std::any visitThisExpr(std::shared_ptr<This> expr) = 0;
-  virtual std::any visitSuperExpr(std::shared_ptr<Super> expr) = 0;
-  virtual std::any visitUnaryExpr(std::shared_ptr<Unary> expr) = 0;
-  virtual std::any visitVariableExpr(std::shared_ptr<Variable> expr) = 0;
-  virtual std::any visitCallExpr(std::shared_ptr<Call> expr) = 0;
-  virtual std::any visitLogicalExpr(std::shared_ptr<Logical> expr) = 0;
+  virtual std::any visitAssignExpr(Assign& expr) = 0;
+  virtual std::any visitBinaryExpr(Binary& expr) = 0;
+  virtual std::any visitGroupingExpr(Grouping& expr) = 0;
+  virtual std::any visitLiteralExpr(Literal& expr) = 0;
+  virtual std::any visitGetExpr(Get& expr) = 0;
+  virtual std::any visitSetExpr(Set& expr) = 0;
+  virtual std::any visitThisExpr(This& expr) = 0;
+  virtual std::any visitSuperExpr(Super& expr) = 0;
+  virtual std::any visitUnaryExpr(Unary& expr) = 0;
+  virtual std::any visitVariableExpr(Variable& expr) = 0;
+  virtual std::any visitCallExpr(Call& expr) = 0;
+  virtual std::any visitLogicalExpr(Logical& expr) = 0;
+  virtual std::any visitIndexExpr(Index& expr) = 0;
+  virtual std::any visitSetIndexExpr(SetIndex& expr) = 0;
+  virtual std::any visitListLiteralExpr(ListLiteral& expr) = 0;
   virtual ~ExprVisitor() = default;
 };
 
@@ -41,130 +51,208 @@ struct Expr {
   virtual std::any accept(ExprVisitor& visitor) = 0;
 };
 
-struct Assign: Expr, public std::enable_shared_from_this<Assign> {
+// How a Binary, Get or Call node is evaluated. Nodes start out
+// UNINITIALIZED and watch the values they see; once the same kind has
+// been seen a few times in a row the node switches to the matching
+// specialized variant, which only checks a single guard. The first time
+// a guard fails the node goes GENERIC for good.
+enum class Specialization : uint8_t {
+  UNINITIALIZED,
+  GENERIC,
+  NUMBER_ADD,
+  NUMBER_SUBTRACT,
+  NUMBER_MULTIPLY,
+  NUMBER_DIVIDE,
+  NUMBER_LESS,
+  NUMBER_LESS_EQUAL,
+  NUMBER_GREATER,
+  NUMBER_GREATER_EQUAL,
+  STRING_CONCAT,
+  INSTANCE_FIELD,
+  MONOMORPHIC_CALL,
+  INLINED_CALL,
+  COUNT
+};
+
+inline const char* specializationName(Specialization specialization) {
+  static const char* names[] = {
+    "Uninitialized", "Generic", "NumberAdd", "NumberSubtract", "NumberMultiply", "NumberDivide",
+    "NumberLess", "NumberLessEqual", "NumberGreater", "NumberGreaterEqual", "StringConcat",
+    "InstanceField", "MonomorphicCall", "InlinedCall"
+  };
+  return names[static_cast<int>(specialization)];
+}
+
+struct SpecializationState {
+  Specialization current = Specialization::UNINITIALIZED;
+  // The kind seen on the previous unspecialized execution, and how many
+  // executions in a row have seen it.
+  Specialization observed = Specialization::UNINITIALIZED;
+  uint8_t samples = 0;
+};
+
+// A type the TypeInference pass proved a value has on every execution.
+// Binary, Unary and Logical nodes and If, While and For statements record
+// it for the operands they check; UNKNOWN means the dynamic checks stay.
+enum class StaticType : uint8_t {
+  UNKNOWN,
+  NIL,
+  BOOL,
+  NUMBER,
+  STRING
+};
+
+// Variable, Assign, This and Super carry a `depth`: the number of scopes
+// between the expression and the variable's declaration, filled in by the
+// parser. -1 means the variable is global.
+//
+// Variable and Assign nodes for globals also cache the global's cell after
+// the first successful lookup, so later accesses skip the name lookup.
+
+struct Assign: Expr {
   Assign(Token name, std::shared_ptr<Expr> value)
     : name{std::move(name)}, value{std::move(value)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitAssignExpr(shared_from_this());
+    return visitor.visitAssignExpr(*this);
   }
 
   const Token name;
   const std::shared_ptr<Expr> value;
+  int depth = -1;
+  std::any* global = nullptr;
 };
 
-struct Binary: Expr, public std::enable_shared_from_this<Binary> {
+struct Binary: Expr {
   Binary(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right)
     : left{std::move(left)}, op{std::move(op)}, right{std::move(right)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitBinaryExpr(shared_from_this());
+    return visitor.visitBinaryExpr(*this);
   }
 
   const std::shared_ptr<Expr> left;
   const Token op;
   const std::shared_ptr<Expr> right;
+  SpecializationState specialization;
+  // NUMBER or STRING when both operands are proven to have that type.
+  StaticType operandType = StaticType::UNKNOWN;
 };
 
-struct Grouping: Expr, public std::enable_shared_from_this<Grouping> {
+struct Grouping: Expr {
   Grouping(std::shared_ptr<Expr> expression)
     : expression{std::move(expression)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitGroupingExpr(shared_from_this());
+    return visitor.visitGroupingExpr(*this);
   }
 
   const std::shared_ptr<Expr> expression;
 };
 
-struct Literal: Expr, public std::enable_shared_from_this<Literal> {
+struct Literal: Expr {
   Literal(std::any value)
     : value{std::move(value)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitLiteralExpr(shared_from_this());
+    return visitor.visitLiteralExpr(*this);
   }
 
   const std::any value;
 };
 
-struct Unary: Expr, public std::enable_shared_from_this<Unary> {
+struct Unary: Expr {
   Unary(Token op, std::shared_ptr<Expr> right)
     : op{std::move(op)}, right{std::move(right)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitUnaryExpr(shared_from_this());
+    return visitor.visitUnaryExpr(*this);
   }
 
   const Token op;
   const std::shared_ptr<Expr> right;
+  StaticType operandType = StaticType::UNKNOWN;
 };
 
-struct Variable: Expr, public std::enable_shared_from_this<Variable> {
+struct Variable: Expr {
   Variable(Token name)
     : name{std::move(name)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitVariableExpr(shared_from_this());
+    return visitor.visitVariableExpr(*this);
   }
 
   const Token name;
+  int depth = -1;
+  std::any* global = nullptr;
 };
 
-struct Logical : public Expr, public std::enable_shared_from_this<Logical> {
+struct Logical : public Expr {
   Logical(std::shared_ptr<Expr> left, Token op, std::shared_ptr<Expr> right)
     : left{std::move(left)}, op{std::move(op)}, right{std::move(right)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitLogicalExpr(shared_from_this());
+    return visitor.visitLogicalExpr(*this);
   }
 
   const std::shared_ptr<Expr> left;
   const Token op;
   const std::shared_ptr<Expr> right;
+  StaticType leftType = StaticType::UNKNOWN;
 };
 
-struct Call : public Expr, public std::enable_shared_from_this<Call> {
+struct Call : public Expr {
   Call(std::shared_ptr<Expr> callee, Token paren, std::vector<std::shared_ptr<Expr>> arguments)
     : callee{std::move(callee)}, paren{std::move(paren)}, arguments{std::move(arguments)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitCallExpr(shared_from_this());
+    return visitor.visitCallExpr(*this);
   }
 
   std::shared_ptr<Expr> callee;
   Token paren;
   std::vector<std::shared_ptr<Expr>> arguments;
+  SpecializationState specialization;
+  // The function declaration or native a MONOMORPHIC_CALL expects. Only
+  // compared, never dereferenced.
+  const void* target = nullptr;
+  // Calls made while MONOMORPHIC_CALL, counted up to Inliner::hotCalls.
+  uint16_t calls = 0;
+  // For an INLINED_CALL, the callee's returned expression spliced in by
+  // the Inliner, and for a method call the class the receiver must have.
+  std::shared_ptr<Expr> inlined;
+  const void* receiverClass = nullptr;
 };
 
-struct Get : public Expr, public std::enable_shared_from_this<Get> {
+struct Get : public Expr {
   Get(std::shared_ptr<Expr> object, Token name)
     : object{std::move(object)}, name{std::move(name)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitGetExpr(shared_from_this());
+    return visitor.visitGetExpr(*this);
   }
 
   std::shared_ptr<Expr> object;
   Token name;
+  SpecializationState specialization;
 };
 
-struct Set : public Expr, public std::enable_shared_from_this<Set> {
+struct Set : public Expr {
   Set(std::shared_ptr<Expr> object, Token name, std::shared_ptr<Expr> value)
     : object{std::move(object)}, name{std::move(name)}, value{std::move(value)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitSetExpr(shared_from_this());
+    return visitor.visitSetExpr(*this);
   }
 
   std::shared_ptr<Expr> object;
@@ -172,29 +260,73 @@ struct Set : public Expr, public std::enable_shared_from_this<Set> {
   std::shared_ptr<Expr> value;
 };
 
-struct This : public Expr, public std::enable_shared_from_this<This> {
+struct This : public Expr {
   This(Token keyword)
     : keyword{std::move(keyword)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitThisExpr(shared_from_this());
+    return visitor.visitThisExpr(*this);
   }
 
   Token keyword;
+  int depth = -1;
 };
 
-struct Super : public Expr, public std::enable_shared_from_this<Super> {
+struct Super : public Expr {
   Super(Token keyword, Token method)
     : keyword{std::move(keyword)}, method{std::move(method)}
   {}
 
   std::any accept(ExprVisitor& visitor) override {
-    return visitor.visitSuperExpr(shared_from_this());
+    return visitor.visitSuperExpr(*this);
   }
 
   Token keyword;
   Token method;
+  int depth = -1;
+};
+
+struct Index : public Expr {
+  Index(std::shared_ptr<Expr> object, Token bracket, std::shared_ptr<Expr> index)
+    : object{std::move(object)}, bracket{std::move(bracket)}, index{std::move(index)}
+  {}
+
+  std::any accept(ExprVisitor& visitor) override {
+    return visitor.visitIndexExpr(*this);
+  }
+
+  std::shared_ptr<Expr> object;
+  Token bracket;
+  std::shared_ptr<Expr> index;
+};
+
+struct SetIndex : public Expr {
+  SetIndex(std::shared_ptr<Expr> object, Token bracket, std::shared_ptr<Expr> index, std::shared_ptr<Expr> value)
+    : object{std::move(object)}, bracket{std::move(bracket)}, index{std::move(index)}, value{std::move(value)}
+  {}
+
+  std::any accept(ExprVisitor& visitor) override {
+    return visitor.visitSetIndexExpr(*this);
+  }
+
+  std::shared_ptr<Expr> object;
+  Token bracket;
+  std::shared_ptr<Expr> index;
+  std::shared_ptr<Expr> value;
+};
+
+struct ListLiteral : public Expr {
+  ListLiteral(Token bracket, std::vector<std::shared_ptr<Expr>> elements)
+    : bracket{std::move(bracket)}, elements{std::move(elements)}
+  {}
+
+  std::any accept(ExprVisitor& visitor) override {
+    return visitor.visitListLiteralExpr(*this);
+  }
+
+  Token bracket;
+  std::vector<std::shared_ptr<Expr>> elements;
 };
 
 #endif  // __EXPR_H
\ No newline at end of file
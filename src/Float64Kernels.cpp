@@ -0,0 +1,287 @@
+#include <cmath>
+#include <limits>
+#include "Float64Kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LOX_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Scalar fallback
+
+double scalarSum(const double* a, size_t n) {
+  double total = 0;
+  for(size_t i = 0; i < n; i++) total += a[i];
+  return total;
+}
+
+double scalarDot(const double* a, const double* b, size_t n) {
+  double total = 0;
+  for(size_t i = 0; i < n; i++) total += a[i] * b[i];
+  return total;
+}
+
+void scalarScale(const double* a, double k, double* out, size_t n) {
+  for(size_t i = 0; i < n; i++) out[i] = a[i] * k;
+}
+
+void scalarAdd(const double* a, const double* b, double* out, size_t n) {
+  for(size_t i = 0; i < n; i++) out[i] = a[i] + b[i];
+}
+
+double scalarMin(const double* a, size_t n) {
+  double result = a[0];
+  for(size_t i = 0; i < n; i++) {
+    if(std::isnan(a[i])) return a[i];
+    if(a[i] < result) result = a[i];
+  }
+  return result;
+}
+
+double scalarMax(const double* a, size_t n) {
+  double result = a[0];
+  for(size_t i = 0; i < n; i++) {
+    if(std::isnan(a[i])) return a[i];
+    if(a[i] > result) result = a[i];
+  }
+  return result;
+}
+
+void scalarPrefixSum(const double* a, double* out, size_t n) {
+  double total = 0;
+  for(size_t i = 0; i < n; i++) out[i] = total += a[i];
+}
+
+double apply(Float64Kernels::UnaryOp op, double x) {
+  switch(op) {
+    case Float64Kernels::UnaryOp::ABS: return std::fabs(x);
+    case Float64Kernels::UnaryOp::NEG: return -x;
+    case Float64Kernels::UnaryOp::SQRT: return std::sqrt(x);
+    case Float64Kernels::UnaryOp::SQUARE: return x * x;
+  }
+  return x;
+}
+
+void scalarMap(const double* a, Float64Kernels::UnaryOp op, double* out, size_t n) {
+  for(size_t i = 0; i < n; i++) out[i] = apply(op, a[i]);
+}
+
+#ifdef LOX_X86_KERNELS
+
+// SSE2 (always available on x86-64)
+
+__attribute__((target("sse2")))
+double sse2Sum(const double* a, size_t n) {
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(a + i));
+    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(a + i + 2));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+  double total = lanes[0] + lanes[1];
+  for(; i < n; i++) total += a[i];
+  return total;
+}
+
+__attribute__((target("sse2")))
+double sse2Dot(const double* a, const double* b, size_t n) {
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+  }
+  double lanes[2];
+  _mm_storeu_pd(lanes, _mm_add_pd(acc0, acc1));
+  double total = lanes[0] + lanes[1];
+  for(; i < n; i++) total += a[i] * b[i];
+  return total;
+}
+
+__attribute__((target("sse2")))
+void sse2Scale(const double* a, double k, double* out, size_t n) {
+  __m128d factor = _mm_set1_pd(k);
+  size_t i = 0;
+  for(; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(a + i), factor));
+  for(; i < n; i++) out[i] = a[i] * k;
+}
+
+__attribute__((target("sse2")))
+void sse2Add(const double* a, const double* b, double* out, size_t n) {
+  size_t i = 0;
+  for(; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  for(; i < n; i++) out[i] = a[i] + b[i];
+}
+
+template <bool isMin>
+__attribute__((target("sse2")))
+double sse2Extreme(const double* a, size_t n) {
+  __m128d best = _mm_set1_pd(a[0]);
+  __m128d nan = _mm_setzero_pd();
+  size_t i = 0;
+  for(; i + 2 <= n; i += 2) {
+    __m128d x = _mm_loadu_pd(a + i);
+    nan = _mm_or_pd(nan, _mm_cmpunord_pd(x, x));
+    best = isMin ? _mm_min_pd(best, x) : _mm_max_pd(best, x);
+  }
+  if(_mm_movemask_pd(nan) != 0) return std::numeric_limits<double>::quiet_NaN();
+  double lanes[2];
+  _mm_storeu_pd(lanes, best);
+  double result = isMin ? std::fmin(lanes[0], lanes[1]) : std::fmax(lanes[0], lanes[1]);
+  for(; i < n; i++) {
+    if(std::isnan(a[i])) return a[i];
+    result = isMin ? std::fmin(result, a[i]) : std::fmax(result, a[i]);
+  }
+  return result;
+}
+
+__attribute__((target("sse2")))
+void sse2PrefixSum(const double* a, double* out, size_t n) {
+  // Scan pairs in registers and carry the running total across them.
+  __m128d carry = _mm_setzero_pd();
+  size_t i = 0;
+  for(; i + 2 <= n; i += 2) {
+    __m128d x = _mm_loadu_pd(a + i);
+    x = _mm_add_pd(x, _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(x), 8)));
+    x = _mm_add_pd(x, carry);
+    _mm_storeu_pd(out + i, x);
+    carry = _mm_unpackhi_pd(x, x);
+  }
+  double total = _mm_cvtsd_f64(carry);
+  for(; i < n; i++) out[i] = total += a[i];
+}
+
+__attribute__((target("sse2")))
+void sse2Map(const double* a, Float64Kernels::UnaryOp op, double* out, size_t n) {
+  const __m128d sign = _mm_set1_pd(-0.0);
+  size_t i = 0;
+  for(; i + 2 <= n; i += 2) {
+    __m128d x = _mm_loadu_pd(a + i);
+    switch(op) {
+      case Float64Kernels::UnaryOp::ABS: x = _mm_andnot_pd(sign, x); break;
+      case Float64Kernels::UnaryOp::NEG: x = _mm_xor_pd(sign, x); break;
+      case Float64Kernels::UnaryOp::SQRT: x = _mm_sqrt_pd(x); break;
+      case Float64Kernels::UnaryOp::SQUARE: x = _mm_mul_pd(x, x); break;
+    }
+    _mm_storeu_pd(out + i, x);
+  }
+  for(; i < n; i++) out[i] = apply(op, a[i]);
+}
+
+// AVX2
+
+__attribute__((target("avx2")))
+double avx2Sum(const double* a, size_t n) {
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+  size_t i = 0;
+  for(; i + 16 <= n; i += 16) {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(a + i));
+    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(a + i + 4));
+    acc2 = _mm256_add_pd(acc2, _mm256_loadu_pd(a + i + 8));
+    acc3 = _mm256_add_pd(acc3, _mm256_loadu_pd(a + i + 12));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+  double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for(; i < n; i++) total += a[i];
+  return total;
+}
+
+__attribute__((target("avx2")))
+double avx2Dot(const double* a, const double* b, size_t n) {
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for(; i + 8 <= n; i += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+  double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for(; i < n; i++) total += a[i] * b[i];
+  return total;
+}
+
+__attribute__((target("avx2")))
+void avx2Scale(const double* a, double k, double* out, size_t n) {
+  __m256d factor = _mm256_set1_pd(k);
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(a + i), factor));
+  for(; i < n; i++) out[i] = a[i] * k;
+}
+
+__attribute__((target("avx2")))
+void avx2Add(const double* a, const double* b, double* out, size_t n) {
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+  for(; i < n; i++) out[i] = a[i] + b[i];
+}
+
+template <bool isMin>
+__attribute__((target("avx2")))
+double avx2Extreme(const double* a, size_t n) {
+  __m256d best = _mm256_set1_pd(a[0]);
+  __m256d nan = _mm256_setzero_pd();
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    __m256d x = _mm256_loadu_pd(a + i);
+    nan = _mm256_or_pd(nan, _mm256_cmp_pd(x, x, _CMP_UNORD_Q));
+    best = isMin ? _mm256_min_pd(best, x) : _mm256_max_pd(best, x);
+  }
+  if(_mm256_movemask_pd(nan) != 0) return std::numeric_limits<double>::quiet_NaN();
+  double lanes[4];
+  _mm256_storeu_pd(lanes, best);
+  double result = lanes[0];
+  for(int lane = 1; lane < 4; lane++) result = isMin ? std::fmin(result, lanes[lane]) : std::fmax(result, lanes[lane]);
+  for(; i < n; i++) {
+    if(std::isnan(a[i])) return a[i];
+    result = isMin ? std::fmin(result, a[i]) : std::fmax(result, a[i]);
+  }
+  return result;
+}
+
+__attribute__((target("avx2")))
+void avx2Map(const double* a, Float64Kernels::UnaryOp op, double* out, size_t n) {
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  size_t i = 0;
+  for(; i + 4 <= n; i += 4) {
+    __m256d x = _mm256_loadu_pd(a + i);
+    switch(op) {
+      case Float64Kernels::UnaryOp::ABS: x = _mm256_andnot_pd(sign, x); break;
+      case Float64Kernels::UnaryOp::NEG: x = _mm256_xor_pd(sign, x); break;
+      case Float64Kernels::UnaryOp::SQRT: x = _mm256_sqrt_pd(x); break;
+      case Float64Kernels::UnaryOp::SQUARE: x = _mm256_mul_pd(x, x); break;
+    }
+    _mm256_storeu_pd(out + i, x);
+  }
+  for(; i < n; i++) out[i] = apply(op, a[i]);
+}
+
+#endif
+
+Float64Kernels select() {
+#ifdef LOX_X86_KERNELS
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) {
+    // The prefix scan carries a dependency through every element, so the
+    // wider registers do not help it; it shares the SSE2 version.
+    return {"avx2", avx2Sum, avx2Dot, avx2Scale, avx2Add, avx2Extreme<true>, avx2Extreme<false>, sse2PrefixSum, avx2Map};
+  }
+  if(__builtin_cpu_supports("sse2")) {
+    return {"sse2", sse2Sum, sse2Dot, sse2Scale, sse2Add, sse2Extreme<true>, sse2Extreme<false>, sse2PrefixSum, sse2Map};
+  }
+#endif
+  return {"scalar", scalarSum, scalarDot, scalarScale, scalarAdd, scalarMin, scalarMax, scalarPrefixSum, scalarMap};
+}
+
+}
+
+const Float64Kernels& Float64Kernels::get() {
+  static const Float64Kernels kernels = select();
+  return kernels;
+}
@@ -0,0 +1,27 @@
+#ifndef __FLOAT64KERNELS_HPP
+#define __FLOAT64KERNELS_HPP
+#include <cstddef>
+
+// Numeric kernels over contiguous doubles used by Float64Array. The
+// implementation is picked once at startup: AVX2 or SSE2 on x86 depending
+// on what the CPU supports, and a portable scalar loop elsewhere. Vector
+// reductions add in a different order than a sequential loop, so sums may
+// differ from it in the last bits.
+struct Float64Kernels {
+  enum class UnaryOp { ABS, NEG, SQRT, SQUARE };
+
+  const char* name;
+  double (*sum)(const double* a, size_t n);
+  double (*dot)(const double* a, const double* b, size_t n);
+  void (*scale)(const double* a, double k, double* out, size_t n);
+  void (*add)(const double* a, const double* b, double* out, size_t n);
+  // Return NaN if any element is NaN. n must be at least 1.
+  double (*min)(const double* a, size_t n);
+  double (*max)(const double* a, size_t n);
+  void (*prefixSum)(const double* a, double* out, size_t n);
+  void (*map)(const double* a, UnaryOp op, double* out, size_t n);
+
+  static const Float64Kernels& get();
+};
+
+#endif
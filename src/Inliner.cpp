@@ -0,0 +1,95 @@
+#include "Inliner.hpp"
+
+using ExprPtr = std::shared_ptr<Expr>;
+
+bool Inliner::isPlainRead(const Expr& expr) {
+  return dynamic_cast<const Literal*>(&expr) != nullptr
+    || dynamic_cast<const Variable*>(&expr) != nullptr
+    || dynamic_cast<const This*>(&expr) != nullptr;
+}
+
+ExprPtr Inliner::splice(const Call& call, const Function& callee, const ExprPtr& receiver) {
+  if(call.arguments.size() != callee.params.size() || callee.body.size() != 1) return nullptr;
+  auto* body = dynamic_cast<Return*>(callee.body[0].get());
+  if(body == nullptr || body->value == nullptr) return nullptr;
+  if(receiver != nullptr && !isPlainRead(*receiver)) return nullptr;
+  for(const ExprPtr& argument : call.arguments) {
+    if(!isPlainRead(*argument)) return nullptr;
+  }
+  Inliner inliner(callee, call.arguments, receiver);
+  return inliner.splice(body->value);
+}
+
+ExprPtr Inliner::splice(const ExprPtr& expr) {
+  if(++nodes > maxNodes) return nullptr;
+  return std::any_cast<ExprPtr>(expr->accept(*this));
+}
+
+std::any Inliner::visitBinaryExpr(Binary& expr) {
+  ExprPtr left = splice(expr.left);
+  ExprPtr right = left == nullptr ? nullptr : splice(expr.right);
+  if(right == nullptr) return ExprPtr();
+  auto copy = std::make_shared<Binary>(left, expr.op, right);
+  // What TypeInference proved about the callee's operands does not depend
+  // on its parameters, which it never proves anything about.
+  copy->operandType = expr.operandType;
+  if(expr.operandType != StaticType::UNKNOWN) copy->specialization.current = expr.specialization.current;
+  return ExprPtr(copy);
+}
+
+std::any Inliner::visitGroupingExpr(Grouping& expr) {
+  ExprPtr expression = splice(expr.expression);
+  if(expression == nullptr) return ExprPtr();
+  return ExprPtr(std::make_shared<Grouping>(expression));
+}
+
+std::any Inliner::visitLiteralExpr(Literal& expr) {
+  return ExprPtr(std::make_shared<Literal>(expr.value));
+}
+
+std::any Inliner::visitLogicalExpr(Logical& expr) {
+  ExprPtr left = splice(expr.left);
+  ExprPtr right = left == nullptr ? nullptr : splice(expr.right);
+  if(right == nullptr) return ExprPtr();
+  auto copy = std::make_shared<Logical>(left, expr.op, right);
+  copy->leftType = expr.leftType;
+  return ExprPtr(copy);
+}
+
+std::any Inliner::visitUnaryExpr(Unary& expr) {
+  ExprPtr right = splice(expr.right);
+  if(right == nullptr) return ExprPtr();
+  auto copy = std::make_shared<Unary>(expr.op, right);
+  copy->operandType = expr.operandType;
+  return ExprPtr(copy);
+}
+
+std::any Inliner::visitGetExpr(Get& expr) {
+  ExprPtr object = splice(expr.object);
+  if(object == nullptr) return ExprPtr();
+  return ExprPtr(std::make_shared<Get>(object, expr.name));
+}
+
+std::any Inliner::visitThisExpr(This& expr) {
+  // `this` is in the scope just outside the method's own.
+  if(receiver == nullptr || expr.depth != 1) return ExprPtr();
+  return receiver;
+}
+
+std::any Inliner::visitVariableExpr(Variable& expr) {
+  if(expr.depth < 0) return ExprPtr(std::make_shared<Variable>(expr.name));
+  if(expr.depth > 0) return ExprPtr();
+  for(size_t i = 0; i < callee.params.size(); i++) {
+    if(callee.params[i].lexeme == expr.name.lexeme) return arguments[i];
+  }
+  return ExprPtr();
+}
+
+// Anything that can assign, call or allocate stays a real call.
+std::any Inliner::visitAssignExpr(Assign& expr) { return ExprPtr(); }
+std::any Inliner::visitCallExpr(Call& expr) { return ExprPtr(); }
+std::any Inliner::visitSetExpr(Set& expr) { return ExprPtr(); }
+std::any Inliner::visitSuperExpr(Super& expr) { return ExprPtr(); }
+std::any Inliner::visitIndexExpr(Index& expr) { return ExprPtr(); }
+std::any Inliner::visitSetIndexExpr(SetIndex& expr) { return ExprPtr(); }
+std::any Inliner::visitListLiteralExpr(ListLiteral& expr) { return ExprPtr(); }
@@ -0,0 +1,61 @@
+#ifndef __INLINER_H
+#define __INLINER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+// Splices small functions into the call sites that keep calling them.
+// A callee qualifies when its body is a single `return` of an expression
+// of at most maxNodes literals, operators, property reads, globals, its
+// parameters and `this`. The site qualifies when every argument, and the
+// receiver of a method call, is a plain read: a literal, a variable or
+// `this`. The spliced expression reads the argument again wherever the
+// callee reads the parameter, which gives the same value because the
+// callee cannot assign or call anything, and a read cannot fail once the
+// site has run. The interpreter checks before each use that the site
+// still calls the same function.
+class Inliner : public ExprVisitor {
+  const Function& callee;
+  const std::vector<std::shared_ptr<Expr>>& arguments;
+  const std::shared_ptr<Expr>& receiver;
+  int nodes = 0;
+
+  Inliner(const Function& callee, const std::vector<std::shared_ptr<Expr>>& arguments, const std::shared_ptr<Expr>& receiver)
+    : callee{callee}, arguments{arguments}, receiver{receiver} {}
+
+  // A copy of `expr` with parameters and `this` replaced, or nullptr if
+  // it cannot be inlined.
+  std::shared_ptr<Expr> splice(const std::shared_ptr<Expr>& expr);
+
+public:
+  // Calls a monomorphic site makes before its callee is inlined.
+  static constexpr uint16_t hotCalls = 16;
+  static constexpr int maxNodes = 16;
+
+  static bool isPlainRead(const Expr& expr);
+  // The expression to evaluate in place of `call` when it calls `callee`
+  // on `receiver` (nullptr for a function call), or nullptr if the call
+  // cannot be inlined.
+  static std::shared_ptr<Expr> splice(const Call& call, const Function& callee, const std::shared_ptr<Expr>& receiver);
+
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include "Interpreter.hpp"
 #include "RuntimeError.hpp"
@@ -6,209 +8,557 @@
 #include "LoxInstance.hpp"
 #include "LoxReturn.hpp"
 #include "LoxClass.hpp"
+#include "LoxString.hpp"
+#include "LoxNative.hpp"
+#include "LoxList.hpp"
+#include "LoxMap.hpp"
+#include "LoxFloat64Array.hpp"
+#include "LoxIsolate.hpp"
+#include "WorkStealingPool.hpp"
+#include "EventLoop.hpp"
+#include "Jit.hpp"
+#include "ClosureCompiler.hpp"
+#include "Inliner.hpp"
+#include "PurityChecker.hpp"
+
+
+Interpreter::Interpreter(Lox& lox, std::ostream& out)
+  : lox{lox}, output{out} {
+  defineNatives();
+}
+
+Interpreter::Interpreter(const Interpreter& parent, std::ostream& out)
+  : lox{parent.lox}, globals{parent.globals}, output{out}, specializing{false} {}
+
+Interpreter::~Interpreter() {
+  closeIsolates();
+}
+
+void Interpreter::closeIsolates() {
+  for(const std::weak_ptr<LoxIsolate>& handle : isolates) {
+    if(std::shared_ptr<LoxIsolate> isolate = handle.lock()) isolate->close();
+  }
+  isolates.clear();
+}
 
+EventLoop& Interpreter::eventLoop() {
+  if(events == nullptr) events = std::make_unique<EventLoop>(*this);
+  return *events;
+}
+
+void Interpreter::enableJit() {
+  if(jit == nullptr) jit = std::make_unique<Jit>(*this);
+}
 
-void Interpreter::resolve(std::shared_ptr<Expr> expr, int depth) {
-  locals[expr] = depth;
+std::unique_ptr<Interpreter> Interpreter::makeWorker() {
+  return std::unique_ptr<Interpreter>(new Interpreter(*this, output.stream()));
 }
 
-std::any Interpreter::visitLiteralExpr(std::shared_ptr<Literal> expr) {
-  return expr->value;
+void Interpreter::defineNatives() {
+  globals->define("clock", std::make_shared<LoxNative>("clock", 0, LoxNative::pure,
+    [](Interpreter&, std::span<std::any>) -> std::any {
+      auto now = std::chrono::system_clock::now().time_since_epoch();
+      return std::chrono::duration<double>(now).count();
+    }));
+  globals->define("len", std::make_shared<LoxNative>("len", 1, LoxNative::pure,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::any& value = arguments[0];
+      if(value.type() == typeid(std::shared_ptr<LoxString>)) {
+        return static_cast<double>(std::any_cast<std::shared_ptr<LoxString>&>(value)->size());
+      }
+      if(value.type() == typeid(std::shared_ptr<LoxList>)) {
+        return static_cast<double>(std::any_cast<std::shared_ptr<LoxList>&>(value)->elements.size());
+      }
+      if(value.type() == typeid(std::shared_ptr<LoxMap>)) {
+        return static_cast<double>(std::any_cast<std::shared_ptr<LoxMap>&>(value)->size());
+      }
+      if(value.type() == typeid(std::shared_ptr<LoxFloat64Array>)) {
+        return static_cast<double>(std::any_cast<std::shared_ptr<LoxFloat64Array>&>(value)->elements.size());
+      }
+      throw NativeError("Argument to 'len' must be a string, list, map or Float64Array.");
+    }));
+  LoxList::defineNatives(*globals);
+  LoxMap::defineNatives(*globals);
+  LoxFloat64Array::defineNatives(*globals);
+  LoxIsolate::defineNatives(*globals);
+  WorkStealingPool::defineNatives(*globals);
+  EventLoop::defineNatives(*globals);
 }
 
-std::any Interpreter::visitGroupingExpr(std::shared_ptr<Grouping> expr) {
-  return evaluate(expr->expression);
+std::any Interpreter::visitLiteralExpr(Literal& expr) {
+  return expr.value;
 }
 
-std::any Interpreter::visitCallExpr(std::shared_ptr<Call> expr) {
-  std::any callee = evaluate(expr->callee);
-  std::vector<std::any> arguments;
-  for(std::shared_ptr<Expr> argument : expr->arguments) {
-    arguments.push_back(evaluate(argument));
+std::any Interpreter::visitGroupingExpr(Grouping& expr) {
+  return evaluate(expr.expression);
+}
+
+std::any Interpreter::visitCallExpr(Call& expr) {
+  if(expr.specialization.current == Specialization::INLINED_CALL && specializing) {
+    if(inlinedCalleeMatches(expr)) return evaluate(expr.inlined);
+    deoptimize(expr.specialization);
+  }
+
+  std::any callee = evaluate(expr.callee);
+  CallArguments arguments(expr.arguments.size());
+  for(size_t i = 0; i < expr.arguments.size(); i++) {
+    arguments[i] = evaluate(expr.arguments[i]);
   }
+
+  auto* loxFunction = std::any_cast<std::shared_ptr<LoxFunction>>(&callee);
+  auto* native = std::any_cast<std::shared_ptr<LoxNative>>(&callee);
+  const void* target = nullptr;
+  if(loxFunction != nullptr) target = (*loxFunction)->declaration.get();
+  if(native != nullptr) target = native->get();
+
+  if(expr.specialization.current == Specialization::MONOMORPHIC_CALL) {
+    if(target == expr.target) {
+      if(loxFunction != nullptr) {
+        if(specializing && expr.calls < Inliner::hotCalls && ++expr.calls == Inliner::hotCalls) inlineCall(expr, **loxFunction);
+        return call(expr.paren, **loxFunction, false, arguments.span());
+      }
+      return call(expr.paren, **native, true, arguments.span());
+    }
+    deoptimize(expr.specialization);
+  } else if(expr.specialization.current == Specialization::UNINITIALIZED && specializing) {
+    // The site stays monomorphic only while it keeps calling the same
+    // function declaration or native.
+    bool same = expr.specialization.samples == 0 || target == expr.target;
+    expr.target = target;
+    observe(expr.specialization, target != nullptr && same ? Specialization::MONOMORPHIC_CALL : Specialization::GENERIC);
+  }
+
   std::shared_ptr<LoxCallable> function; 
-  if(callee.type() == typeid(std::shared_ptr<LoxFunction>)) {
-    function = std::any_cast<std::shared_ptr<LoxFunction>>(callee);
+  if(loxFunction != nullptr) {
+    function = *loxFunction;
   } else if(callee.type() == typeid(std::shared_ptr<LoxClass>)) {
     function = std::any_cast<std::shared_ptr<LoxClass>>(callee);
+  } else if(native != nullptr) {
+    function = *native;
   } else {
-    throw RuntimeError(expr->paren, "Can only call functions and classes.");
+    throw RuntimeError(expr.paren, "Can only call functions and classes.");
   }
-  
-  if(arguments.size() != function->arity()) {
-    throw RuntimeError(expr->paren, "Expected " + std::to_string(function->arity()) + " arguments but got " + std::to_string(arguments.size()) + ".");
+  return call(expr.paren, *function, native != nullptr, arguments.span());
+}
+
+void Interpreter::inlineCall(Call& expr, LoxFunction& function) {
+  if(function.isInitializer) return;
+  std::shared_ptr<Expr> receiver;
+  const LoxClass* receiverClass = nullptr;
+  if(auto* get = dynamic_cast<Get*>(expr.callee.get())) {
+    // Only a method found on the receiver's class can be inlined, not a
+    // function stored in one of its fields. The receiver is a plain read,
+    // so reading it again here is harmless.
+    if(!Inliner::isPlainRead(*get->object)) return;
+    std::any object = evaluate(get->object);
+    auto* instance = std::any_cast<std::shared_ptr<LoxInstance>>(&object);
+    if(instance == nullptr || (*instance)->findField(get->name.lexeme) != nullptr) return;
+    receiver = get->object;
+    receiverClass = (*instance)->klass.get();
+  } else if(dynamic_cast<Variable*>(expr.callee.get()) == nullptr) {
+    return;
   }
+  expr.inlined = Inliner::splice(expr, *function.declaration, receiver);
+  if(expr.inlined == nullptr) return;
+  expr.receiverClass = receiverClass;
+  expr.specialization.current = Specialization::INLINED_CALL;
+  specializedSites[static_cast<size_t>(Specialization::INLINED_CALL)]++;
+}
 
-  return function->call(*this, std::move(arguments));
+bool Interpreter::inlinedCalleeMatches(Call& expr) {
+  if(expr.receiverClass != nullptr) {
+    // Classes never change their methods, so the receiver's class decides
+    // which method a Get finds, unless a field hides it.
+    Get& get = static_cast<Get&>(*expr.callee);
+    std::any object = evaluate(get.object);
+    auto* instance = std::any_cast<std::shared_ptr<LoxInstance>>(&object);
+    return instance != nullptr && (*instance)->klass.get() == expr.receiverClass
+      && (*instance)->findField(get.name.lexeme) == nullptr;
+  }
+  // Closures over the same declaration behave alike here: the inlined
+  // expression reads no variables of the closure.
+  std::any callee = evaluate(expr.callee);
+  auto* function = std::any_cast<std::shared_ptr<LoxFunction>>(&callee);
+  return function != nullptr && (*function)->declaration.get() == expr.target;
 }
 
-std::any Interpreter::visitFunctionStmt(std::shared_ptr<Function> stmt) {
-  auto function = std::make_shared<LoxFunction>(stmt, environment, false);
-  environment->define(stmt->name.lexeme, function);
+std::unique_ptr<MemoCache> Interpreter::memoCache(const LoxFunction& function) {
+  if(!memoize && !function.declaration->pure) return nullptr;
+  PurityChecker checker(*this, true);
+  if(!checker.isPure(function)) {
+    memoRejected++;
+    return nullptr;
+  }
+  memoizedFunctions++;
+  auto cache = std::make_unique<MemoCache>();
+  cache->callees = std::move(checker.callees);
+  return cache;
+}
+
+std::any Interpreter::call(const Token& paren, LoxCallable& function, bool native, std::span<std::any> arguments) {
+  if(arguments.size() != function.arity()) {
+    throw RuntimeError(paren, "Expected " + std::to_string(function.arity()) + " arguments but got " + std::to_string(arguments.size()) + ".");
+  }
+
+  if(native) {
+    try {
+      return function.call(*this, arguments);
+    } catch(NativeError& error) {
+      throw RuntimeError(paren, error.what());
+    }
+  }
+  return function.call(*this, arguments);
+}
+
+std::any Interpreter::visitIndexExpr(Index& expr) {
+  std::any object = evaluate(expr.object);
+  std::any index = evaluate(expr.index);
+  return this->index(expr.bracket, object, index);
+}
+
+std::any Interpreter::index(const Token& bracket, std::any& object, std::any& index) {
+  if(object.type() == typeid(std::shared_ptr<LoxList>)) {
+    std::vector<std::any>& elements = std::any_cast<std::shared_ptr<LoxList>&>(object)->elements;
+    return elements[checkIndex(bracket, index, elements.size())];
+  }
+  if(object.type() == typeid(std::shared_ptr<LoxFloat64Array>)) {
+    std::vector<double>& elements = std::any_cast<std::shared_ptr<LoxFloat64Array>&>(object)->elements;
+    return elements[checkIndex(bracket, index, elements.size())];
+  }
+  if(object.type() == typeid(std::shared_ptr<LoxMap>)) {
+    std::any* value;
+    try {
+      value = std::any_cast<std::shared_ptr<LoxMap>&>(object)->find(index);
+    } catch(NativeError& error) {
+      throw RuntimeError(bracket, error.what());
+    }
+    if(value == nullptr) throw RuntimeError(bracket, "Undefined key.");
+    return *value;
+  }
+  throw RuntimeError(bracket, "Only lists, maps and arrays can be indexed.");
+}
+
+std::any Interpreter::visitSetIndexExpr(SetIndex& expr) {
+  std::any object = evaluate(expr.object);
+  checkIndexable(expr.bracket, object);
+  std::any index = evaluate(expr.index);
+  std::any value = evaluate(expr.value);
+  setIndex(expr.bracket, object, index, value);
+  return value;
+}
+
+void Interpreter::checkIndexable(const Token& bracket, std::any& object) {
+  if(object.type() == typeid(std::shared_ptr<LoxMap>)) return;
+  if(object.type() == typeid(std::shared_ptr<LoxFloat64Array>)) return;
+  if(object.type() == typeid(std::shared_ptr<LoxList>)) return;
+  throw RuntimeError(bracket, "Only lists, maps and arrays can be indexed.");
+}
+
+void Interpreter::setIndex(const Token& bracket, std::any& object, std::any& index, std::any& value) {
+  if(object.type() == typeid(std::shared_ptr<LoxMap>)) {
+    try {
+      std::any_cast<std::shared_ptr<LoxMap>&>(object)->set(index, value);
+    } catch(NativeError& error) {
+      throw RuntimeError(bracket, error.what());
+    }
+    return;
+  }
+  if(object.type() == typeid(std::shared_ptr<LoxFloat64Array>)) {
+    std::vector<double>& elements = std::any_cast<std::shared_ptr<LoxFloat64Array>&>(object)->elements;
+    size_t position = checkIndex(bracket, index, elements.size());
+    if(value.type() != typeid(double)) {
+      throw RuntimeError(bracket, "Float64Array elements must be numbers.");
+    }
+    elements[position] = std::any_cast<double>(value);
+    return;
+  }
+  std::vector<std::any>& elements = std::any_cast<std::shared_ptr<LoxList>&>(object)->elements;
+  elements[checkIndex(bracket, index, elements.size())] = value;
+}
+
+std::any Interpreter::visitListLiteralExpr(ListLiteral& expr) {
+  std::vector<std::any> elements;
+  elements.reserve(expr.elements.size());
+  for(const std::shared_ptr<Expr>& element : expr.elements) {
+    elements.push_back(evaluate(element));
+  }
+  return std::make_shared<LoxList>(std::move(elements));
+}
+
+std::any Interpreter::visitFunctionStmt(Function& stmt) {
+  auto function = std::make_shared<LoxFunction>(stmt.shared_from_this(), environment, false);
+  environment->define(stmt.name.lexeme, function);
   return {};
 }
 
-std::any Interpreter::visitUnaryExpr(std::shared_ptr<Unary> expr) {
-  std::any right = evaluate(expr->right);
-  switch(expr->op.type) {
+std::any Interpreter::visitUnaryExpr(Unary& expr) {
+  std::any right = evaluate(expr.right);
+  switch(expr.op.type) {
     case TokenType::BANG:
-      return !isTruthy(right);
+      return !isTruthy(right, expr.operandType);
     case TokenType::MINUS:
-      checkNumberOperands(expr->op, right, right);
+      if(expr.operandType != StaticType::NUMBER) checkNumberOperands(expr.op, right, right);
       return -std::any_cast<double>(right);
   }
   return {};
 }
 
-std::any Interpreter::visitBinaryExpr(std::shared_ptr<Binary> expr) {
-  std::any left = evaluate(expr->left);
-  std::any right = evaluate(expr->right);
-  switch(expr->op.type) {
+std::any Interpreter::visitBinaryExpr(Binary& expr) {
+  std::any left = evaluate(expr.left);
+  std::any right = evaluate(expr.right);
+
+  Specialization specialization = expr.specialization.current;
+  if(specialization > Specialization::GENERIC) {
+    if(specialization == Specialization::STRING_CONCAT) {
+      auto* a = std::any_cast<std::shared_ptr<LoxString>>(&left);
+      auto* b = std::any_cast<std::shared_ptr<LoxString>>(&right);
+      if(a != nullptr && b != nullptr) return LoxString::concat(*a, *b);
+    } else {
+      double* a = std::any_cast<double>(&left);
+      double* b = std::any_cast<double>(&right);
+      if(a != nullptr && b != nullptr) {
+        switch(specialization) {
+          case Specialization::NUMBER_ADD: return *a + *b;
+          case Specialization::NUMBER_SUBTRACT: return *a - *b;
+          case Specialization::NUMBER_MULTIPLY: return *a * *b;
+          case Specialization::NUMBER_DIVIDE: return *a / *b;
+          case Specialization::NUMBER_LESS: return *a < *b;
+          case Specialization::NUMBER_LESS_EQUAL: return *a <= *b;
+          case Specialization::NUMBER_GREATER: return *a > *b;
+          case Specialization::NUMBER_GREATER_EQUAL: return *a >= *b;
+        }
+      }
+    }
+    deoptimize(expr.specialization);
+  } else if(specialization == Specialization::UNINITIALIZED && specializing) {
+    Specialization seen = Specialization::GENERIC;
+    bool numbers = left.type() == typeid(double) && right.type() == typeid(double);
+    switch(expr.op.type) {
+      case TokenType::PLUS:
+        if(numbers) seen = Specialization::NUMBER_ADD;
+        else if(left.type() == typeid(std::shared_ptr<LoxString>) && right.type() == typeid(std::shared_ptr<LoxString>)) seen = Specialization::STRING_CONCAT;
+        break;
+      case TokenType::MINUS: if(numbers) seen = Specialization::NUMBER_SUBTRACT; break;
+      case TokenType::STAR: if(numbers) seen = Specialization::NUMBER_MULTIPLY; break;
+      case TokenType::SLASH: if(numbers) seen = Specialization::NUMBER_DIVIDE; break;
+      case TokenType::LESS: if(numbers) seen = Specialization::NUMBER_LESS; break;
+      case TokenType::LESS_EQUAL: if(numbers) seen = Specialization::NUMBER_LESS_EQUAL; break;
+      case TokenType::GREATER: if(numbers) seen = Specialization::NUMBER_GREATER; break;
+      case TokenType::GREATER_EQUAL: if(numbers) seen = Specialization::NUMBER_GREATER_EQUAL; break;
+    }
+    observe(expr.specialization, seen);
+  }
+
+  switch(expr.op.type) {
     case TokenType::BANG_EQUAL: return !isEqual(left, right);
     case TokenType::EQUAL_EQUAL: return isEqual(left, right);
     case TokenType::GREATER:
-      checkNumberOperands(expr->op, left, right);
+      checkNumberOperands(expr.op, left, right);
       return std::any_cast<double>(left) > std::any_cast<double>(right);
     case TokenType::GREATER_EQUAL:
-      checkNumberOperands(expr->op, left, right);
+      checkNumberOperands(expr.op, left, right);
       return std::any_cast<double>(left) >= std::any_cast<double>(right);
     case TokenType::LESS:
-      checkNumberOperands(expr->op, left, right);
+      checkNumberOperands(expr.op, left, right);
       return std::any_cast<double>(left) < std::any_cast<double>(right);
     case TokenType::LESS_EQUAL:
-      checkNumberOperands(expr->op, left, right);
+      checkNumberOperands(expr.op, left, right);
       return std::any_cast<double>(left) <= std::any_cast<double>(right);
     case TokenType::MINUS:
-      checkNumberOperands(expr->op, left, right);
+      checkNumberOperands(expr.op, left, right);
       return std::any_cast<double>(left) - std::any_cast<double>(right);
     case TokenType::PLUS:
       if(left.type() == typeid(double) && right.type() == typeid(double)) {
         return std::any_cast<double>(left) + std::any_cast<double>(right);
       }
-      if(left.type() == typeid(std::string) && right.type() == typeid(std::string)) {
-        return std::any_cast<std::string>(left) + std::any_cast<std::string>(right);
+      if(left.type() == typeid(std::shared_ptr<LoxString>) && right.type() == typeid(std::shared_ptr<LoxString>)) {
+        return LoxString::concat(std::any_cast<std::shared_ptr<LoxString>&>(left), std::any_cast<std::shared_ptr<LoxString>&>(right));
       }
-      throw RuntimeError(expr->op, "Operands must be two numbers or two strings.");
+      throw RuntimeError(expr.op, "Operands must be two numbers or two strings.");
     case TokenType::SLASH:
-      checkNumberOperands(expr->op, left, right);
+      checkNumberOperands(expr.op, left, right);
       return std::any_cast<double>(left) / std::any_cast<double>(right);
     case TokenType::STAR:
-      checkNumberOperands(expr->op, left, right);
+      checkNumberOperands(expr.op, left, right);
       return std::any_cast<double>(left) * std::any_cast<double>(right);
   }
   return {};
 }
 
-std::any Interpreter::visitAssignExpr(std::shared_ptr<Assign> expr) {
-  std::any value = evaluate(expr->value);
-  auto elem = locals.find(expr);
-  if (elem != locals.end()) {
-    int distance = elem->second;
-    environment->assignAt(distance, expr->name, value);
+std::any Interpreter::visitAssignExpr(Assign& expr) {
+  std::any value = evaluate(expr.value);
+  if (expr.depth >= 0) {
+    environment->assignAt(expr.depth, expr.name, value);
   } else {
-    globals->assign(expr->name, value);
+    *globalCell(expr.name, expr.global) = value;
   }
 
   return value;
 }
 
-std::any Interpreter::visitVariableExpr(std::shared_ptr<Variable> expr) {
-  return lookUpVariable(expr->name, expr);
+std::any Interpreter::visitVariableExpr(Variable& expr) {
+  if(expr.depth < 0) return *globalCell(expr.name, expr.global);
+  return environment->getAt(expr.depth, expr.name.lexeme);
+}
+
+void Interpreter::observe(SpecializationState& state, Specialization seen) {
+  static constexpr uint8_t samplesToSpecialize = 3;
+  if(seen == Specialization::GENERIC) {
+    state.current = Specialization::GENERIC;
+    return;
+  }
+  if(seen != state.observed) {
+    state.observed = seen;
+    state.samples = 0;
+  }
+  if(++state.samples < samplesToSpecialize) return;
+  state.current = seen;
+  specializedSites[static_cast<size_t>(seen)]++;
+}
+
+void Interpreter::deoptimize(SpecializationState& state) {
+  if(!specializing) return;
+  state.current = Specialization::GENERIC;
+  deoptimizedSites++;
 }
 
-std::any Interpreter::lookUpVariable(Token name, std::shared_ptr<Expr> expr) {
-  auto elem = locals.find(expr);
-  if(elem != locals.end()) {
-    int distance = elem->second;
-    return environment->getAt(distance, name.lexeme);
+std::any* Interpreter::globalCell(const Token& name, std::any*& cache) {
+  if(cache != nullptr) return cache;
+  std::any* cell = globals->find(name.lexeme);
+  if(cell == nullptr) throw RuntimeError(name, "Undefined variable '" + name.lexeme + "'.");
+  // Workers share the AST and must not write to it.
+  if(specializing) cache = cell;
+  return cell;
+}
+
+std::any Interpreter::lookUpVariable(const Token& name, int depth) {
+  if(depth >= 0) {
+    return environment->getAt(depth, name.lexeme);
   } else {
     return globals->get(name);
   }
 }
 
 
-std::any Interpreter::visitLogicalExpr(std::shared_ptr<Logical> expr) {
-  std::any left = evaluate(expr->left);
-  if(expr->op.type == TokenType::OR) {
-    if(isTruthy(left)) return left;
+std::any Interpreter::visitLogicalExpr(Logical& expr) {
+  std::any left = evaluate(expr.left);
+  if(expr.op.type == TokenType::OR) {
+    if(isTruthy(left, expr.leftType)) return left;
   } else {
-    if(!isTruthy(left)) return left;
+    if(!isTruthy(left, expr.leftType)) return left;
   }
-  return evaluate(expr->right);
+  return evaluate(expr.right);
 }
 
-std::any Interpreter::visitGetExpr(std::shared_ptr<Get> expr) {
-  std::any object = evaluate(expr->object);
-  if(object.type() == typeid(std::shared_ptr<LoxInstance>)) {
-    return std::any_cast<std::shared_ptr<LoxInstance>>(object)->get(expr->name);
+std::any Interpreter::visitGetExpr(Get& expr) {
+  std::any object = evaluate(expr.object);
+  auto* instance = std::any_cast<std::shared_ptr<LoxInstance>>(&object);
+
+  if(expr.specialization.current == Specialization::INSTANCE_FIELD) {
+    if(instance != nullptr) {
+      if(std::any* field = (*instance)->findField(expr.name.lexeme)) return *field;
+    }
+    deoptimize(expr.specialization);
+  } else if(expr.specialization.current == Specialization::UNINITIALIZED && specializing) {
+    bool field = instance != nullptr && (*instance)->findField(expr.name.lexeme) != nullptr;
+    observe(expr.specialization, field ? Specialization::INSTANCE_FIELD : Specialization::GENERIC);
   }
-  throw RuntimeError(expr->name, "Only instances have properties.");
+
+  if(instance != nullptr) {
+    return (*instance)->get(expr.name);
+  }
+  throw RuntimeError(expr.name, "Only instances have properties.");
 }
 
-std::any Interpreter::visitSetExpr(std::shared_ptr<Set> expr) {
-  std::any object = evaluate(expr->object);
+std::any Interpreter::visitSetExpr(Set& expr) {
+  std::any object = evaluate(expr.object);
   if(object.type() != typeid(std::shared_ptr<LoxInstance>)) {
-    throw RuntimeError(expr->name, "Only instances have fields.");
+    throw RuntimeError(expr.name, "Only instances have fields.");
   }
-  std::any value = evaluate(expr->value);
-  std::any_cast<std::shared_ptr<LoxInstance>>(object)->set(expr->name, value);
+  std::any value = evaluate(expr.value);
+  std::any_cast<std::shared_ptr<LoxInstance>>(object)->set(expr.name, value);
   return value;
 }
 
-std::any Interpreter::visitThisExpr(std::shared_ptr<This> expr) {
-  return lookUpVariable(expr->keyword, expr);
+std::any Interpreter::visitThisExpr(This& expr) {
+  return lookUpVariable(expr.keyword, expr.depth);
 }
 
-std::any Interpreter::visitSuperExpr(std::shared_ptr<Super> expr) {
-  int distance = locals[expr];
+std::any Interpreter::visitSuperExpr(Super& expr) {
+  int distance = expr.depth;
   auto superclass = std::any_cast<std::shared_ptr<LoxClass>>(environment->getAt(distance, "super"));
   auto object = std::any_cast<std::shared_ptr<LoxInstance>>(environment->getAt(distance - 1, "this"));
-  std::shared_ptr<LoxFunction> method = superclass->findMethod(expr->method.lexeme);
+  std::shared_ptr<LoxFunction> method = superclass->findMethod(expr.method.lexeme);
   if(method == nullptr) {
-    throw RuntimeError(expr->method, "Undefined property '" + expr->method.lexeme + "'.");
+    throw RuntimeError(expr.method, "Undefined property '" + expr.method.lexeme + "'.");
   }
   return method->bind(object);
 }
-std::any Interpreter::visitIfStmt(std::shared_ptr<If> stmt) {
-  std::any conditionAny = evaluate(stmt->condition);
-  if(isTruthy(conditionAny)) {
-    execute(stmt->thenBranch);
-  } else if(stmt->elseBranch != nullptr) {
-    execute(stmt->elseBranch);
+std::any Interpreter::visitIfStmt(If& stmt) {
+  std::any conditionAny = evaluate(stmt.condition);
+  if(isTruthy(conditionAny, stmt.conditionType)) {
+    execute(stmt.thenBranch);
+  } else if(stmt.elseBranch != nullptr) {
+    execute(stmt.elseBranch);
   }
   return {};
 }
 
-std::any Interpreter::visitReturnStmt(std::shared_ptr<Return> stmt) {
+std::any Interpreter::visitReturnStmt(Return& stmt) {
   std::any value = nullptr;
-  if(stmt->value != nullptr) value = evaluate(stmt->value);
+  if(stmt.value != nullptr) value = evaluate(stmt.value);
   throw LoxReturn(value);
 }
-std::any Interpreter::visitWhileStmt(std::shared_ptr<While> stmt) {
-  std::any condition = evaluate(stmt->condition);
-  while(isTruthy(condition)) {
-    execute(stmt->body);
-    condition = evaluate(stmt->condition);
+std::any Interpreter::visitWhileStmt(While& stmt) {
+  std::any condition = evaluate(stmt.condition);
+  while(isTruthy(condition, stmt.conditionType)) {
+    execute(stmt.body);
+    condition = evaluate(stmt.condition);
+  }
+  return {};
+}
+
+std::any Interpreter::visitForStmt(For& stmt) {
+  std::shared_ptr<Environment> previous = environment;
+  try {
+    if(stmt.initializer != nullptr) {
+      environment = std::make_shared<Environment>(environment);
+      execute(stmt.initializer);
+    }
+    Block* block = stmt.reuseBodyScope ? dynamic_cast<Block*>(stmt.body.get()) : nullptr;
+    std::shared_ptr<Environment> bodyEnvironment;
+    if(block != nullptr) bodyEnvironment = std::make_shared<Environment>(environment);
+    std::any condition = evaluate(stmt.condition);
+    while(isTruthy(condition, stmt.conditionType)) {
+      if(block != nullptr) executeBlock(block->statements, bodyEnvironment);
+      else execute(stmt.body);
+      if(stmt.increment != nullptr) evaluate(stmt.increment);
+      condition = evaluate(stmt.condition);
+    }
+  } catch (...) {
+    environment = previous;
+    throw;
   }
+  environment = previous;
   return {};
 }
 
-std::any Interpreter::visitClassStmt(std::shared_ptr<Class> stmt) {
+std::any Interpreter::visitClassStmt(Class& stmt) {
   std::any superClass;
-  if(stmt->superclass != nullptr) {
-    superClass = evaluate(stmt->superclass);
+  if(stmt.superclass != nullptr) {
+    superClass = evaluate(stmt.superclass);
     if(superClass.type() != typeid(std::shared_ptr<LoxClass>)) {
-      throw RuntimeError(stmt->superclass->name, "Superclass must be a class.");
+      throw RuntimeError(stmt.superclass->name, "Superclass must be a class.");
     }
   }
-  environment->define(stmt->name.lexeme, nullptr);
-  if(stmt->superclass != nullptr) {
+  environment->define(stmt.name.lexeme, nullptr);
+  if(stmt.superclass != nullptr) {
     environment = std::make_shared<Environment>(environment);
     environment->define("super", superClass);
   }
 
   std::map<std::string, std::shared_ptr<LoxFunction>> methods;
-  for(std::shared_ptr<Function> method : stmt->methods) {
+  for(const std::shared_ptr<Function>& method : stmt.methods) {
     auto function = std::make_shared<LoxFunction>(method, environment, method->name.lexeme == "init");
     methods[method->name.lexeme] = function;
   }
@@ -216,16 +566,16 @@ std::any Interpreter::visitClassStmt(std::shared_ptr<Class> stmt) {
   if(superClass.type() == typeid(std::shared_ptr<LoxClass>)) {
     superKlass = std::any_cast<std::shared_ptr<LoxClass>>(superClass);
   }
-  auto klass = std::make_shared<LoxClass>(stmt->name.lexeme, superKlass, methods);
+  auto klass = std::make_shared<LoxClass>(stmt.name.lexeme, superKlass, methods);
   if(superKlass != nullptr) {
     environment = environment->enclosing;
   }
 
-  environment->assign(stmt->name, std::move(klass));
+  environment->assign(stmt.name, std::move(klass));
   return {};
 }
 
-std::any Interpreter::evaluate(std::shared_ptr<Expr> expr) {
+std::any Interpreter::evaluate(const std::shared_ptr<Expr>& expr) {
   return expr->accept(*this);
 }
 
@@ -240,46 +590,136 @@ void Interpreter::checkNumberOperands(const Token& op, std::any& left, std::any&
   throw RuntimeError(op, "Operands must be numbers.");
 }
 
+size_t Interpreter::checkIndex(const Token& bracket, std::any& index, size_t size) {
+  if(index.type() != typeid(double)) {
+    throw RuntimeError(bracket, "Index must be a number.");
+  }
+  double position = std::any_cast<double>(index);
+  if(position != std::floor(position)) {
+    throw RuntimeError(bracket, "Index must be an integer.");
+  }
+  if(position < 0 || position >= size) {
+    throw RuntimeError(bracket, "Index out of bounds.");
+  }
+  return static_cast<size_t>(position);
+}
+
 bool Interpreter::isEqual(std::any& a, std::any& b) {
   if(a.type() == typeid(nullptr) && b.type() == typeid(nullptr)) return true;
   if(a.type() == typeid(nullptr)) return false;
-  if(a.type() == typeid(std::string) && b.type() == typeid(std::string))
-    return std::any_cast<std::string>(a) == std::any_cast<std::string>(b);
+  if(a.type() == typeid(std::shared_ptr<LoxString>) && b.type() == typeid(std::shared_ptr<LoxString>))
+    return std::any_cast<std::shared_ptr<LoxString>&>(a)->equals(*std::any_cast<std::shared_ptr<LoxString>&>(b));
   if(a.type() == typeid(double) && b.type() == typeid(double))
     return std::any_cast<double>(a) == std::any_cast<double>(b);
   if(a.type() == typeid(bool) && b.type() == typeid(bool))
     return std::any_cast<bool>(a) == std::any_cast<bool>(b);
+  if(a.type() == typeid(std::shared_ptr<LoxList>) && b.type() == typeid(std::shared_ptr<LoxList>))
+    return std::any_cast<std::shared_ptr<LoxList>&>(a) == std::any_cast<std::shared_ptr<LoxList>&>(b);
+  if(a.type() == typeid(std::shared_ptr<LoxMap>) && b.type() == typeid(std::shared_ptr<LoxMap>))
+    return std::any_cast<std::shared_ptr<LoxMap>&>(a) == std::any_cast<std::shared_ptr<LoxMap>&>(b);
+  if(a.type() == typeid(std::shared_ptr<LoxFloat64Array>) && b.type() == typeid(std::shared_ptr<LoxFloat64Array>))
+    return std::any_cast<std::shared_ptr<LoxFloat64Array>&>(a) == std::any_cast<std::shared_ptr<LoxFloat64Array>&>(b);
   return false;
 }
 
 std::string Interpreter::stringify(std::any& object) {
   if(object.type() == typeid(nullptr)) return "nil";
   if(object.type() == typeid(double)) {
-    std::string text = std::to_string(std::any_cast<double>(object));
-    if(text[text.length() - 2]  == '.' && text[text.length() - 1] == '0') {
-      text = text.substr(0, text.length() - 2);
-    }
-    return text;
+    char text[OutputBuffer::maxNumberLength];
+    char* end = OutputBuffer::formatNumber(text, text + sizeof(text), std::any_cast<double>(object));
+    return std::string(text, end);
   }
-  if(object.type() == typeid(std::string)) return std::any_cast<std::string>(object);
+  if(object.type() == typeid(std::shared_ptr<LoxString>)) return std::any_cast<std::shared_ptr<LoxString>&>(object)->str();
   if(object.type() == typeid(bool)) return std::any_cast<bool>(object) ? "true" : "false";
   if(object.type() == typeid(std::shared_ptr<LoxFunction>)) return std::any_cast<std::shared_ptr<LoxFunction>>(object)->toString();
   if(object.type() == typeid(std::shared_ptr<LoxClass>)) return std::any_cast<std::shared_ptr<LoxClass>>(object)->toString();
   if(object.type() == typeid(std::shared_ptr<LoxInstance>)) return std::any_cast<std::shared_ptr<LoxInstance>>(object)->toString();
+  if(object.type() == typeid(std::shared_ptr<LoxNative>)) return std::any_cast<std::shared_ptr<LoxNative>>(object)->toString();
+  if(object.type() == typeid(std::shared_ptr<LoxIsolate>)) return "<isolate>";
+#ifdef __linux__
+  if(object.type() == typeid(std::shared_ptr<LoxTask>)) return "<task>";
+#endif
+  if(object.type() == typeid(std::shared_ptr<LoxList>)) {
+    std::shared_ptr<LoxList> list = std::any_cast<std::shared_ptr<LoxList>>(object);
+    // A list that contains itself is printed as [...] at the inner level.
+    if(std::find(printing.begin(), printing.end(), list.get()) != printing.end()) return "[...]";
+    printing.push_back(list.get());
+    std::string text = "[";
+    for(size_t i = 0; i < list->elements.size(); i++) {
+      if(i > 0) text += ", ";
+      text += stringify(list->elements[i]);
+    }
+    printing.pop_back();
+    return text + "]";
+  }
+  if(object.type() == typeid(std::shared_ptr<LoxFloat64Array>)) {
+    std::shared_ptr<LoxFloat64Array> array = std::any_cast<std::shared_ptr<LoxFloat64Array>>(object);
+    std::string text = "[";
+    char number[OutputBuffer::maxNumberLength];
+    for(size_t i = 0; i < array->elements.size(); i++) {
+      if(i > 0) text += ", ";
+      text.append(number, OutputBuffer::formatNumber(number, number + sizeof(number), array->elements[i]));
+    }
+    return text + "]";
+  }
+  if(object.type() == typeid(std::shared_ptr<LoxMap>)) {
+    std::shared_ptr<LoxMap> map = std::any_cast<std::shared_ptr<LoxMap>>(object);
+    if(std::find(printing.begin(), printing.end(), map.get()) != printing.end()) return "{...}";
+    printing.push_back(map.get());
+    std::string text = "{";
+    bool first = true;
+    for(auto [key, value] : map->items()) {
+      if(!first) text += ", ";
+      first = false;
+      text += stringify(const_cast<std::any&>(*key)) + ": " + stringify(const_cast<std::any&>(*value));
+    }
+    printing.pop_back();
+    return text + "}";
+  }
   return "Error in stringify: Object type not recognized.\n";
 }
 
-void Interpreter::interpret(std::vector<std::shared_ptr<Stmt>>& statements) {
+void Interpreter::print(std::any& object) {
+  // Write the common value types straight into the output buffer.
+  if(object.type() == typeid(double)) {
+    output.writeNumber(std::any_cast<double>(object));
+  } else if(object.type() == typeid(std::shared_ptr<LoxString>)) {
+    output.write(std::any_cast<std::shared_ptr<LoxString>&>(object)->str());
+  } else if(object.type() == typeid(bool)) {
+    output.write(std::any_cast<bool>(object) ? "true" : "false");
+  } else if(object.type() == typeid(nullptr)) {
+    output.write("nil");
+  } else {
+    output.write(stringify(object));
+  }
+  output.newline();
+}
+
+bool Interpreter::interpret(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  // Runtime errors refer to tokens held by the closures, so they must
+  // outlive the handler below.
+  std::vector<ClosureCompiler::Exec> compiled;
   try {
-    for(auto& statement : statements) {
-      execute(statement);
+    if(engine == Engine::CLOSURE) {
+      compiled = ClosureCompiler::compile(statements);
+      for(const ClosureCompiler::Exec& statement : compiled) {
+        statement(*this);
+      }
+    } else {
+      for(auto& statement : statements) {
+        execute(statement);
+      }
     }
+    // Tasks the script started run to completion after it ends.
+    if(events != nullptr) events->drain();
   } catch (RuntimeError& error) {
-    Lox::runtimeError(error);
+    lox.runtimeError(error);
+    return false;
   }
+  return true;
 }
 
-void Interpreter::execute(std::shared_ptr<Stmt> stmt) {
+void Interpreter::execute(const std::shared_ptr<Stmt>& stmt) {
   stmt->accept(*this);
 }
 
@@ -287,7 +727,7 @@ void Interpreter::executeBlock(const std::vector<std::shared_ptr<Stmt>>& stateme
   std::shared_ptr<Environment> previous = this->environment;
   try {
     this->environment = environment;
-    for (std::shared_ptr<Stmt> statement : statements) {
+    for (const std::shared_ptr<Stmt>& statement : statements) {
       execute(statement);
     }
   } catch (...) {
@@ -297,27 +737,27 @@ void Interpreter::executeBlock(const std::vector<std::shared_ptr<Stmt>>& stateme
   this->environment = previous;
 }
 
-std::any Interpreter::visitBlockStmt(std::shared_ptr<Block> stmt) {
-  executeBlock(stmt->statements, std::make_shared<Environment>(environment));
+std::any Interpreter::visitBlockStmt(Block& stmt) {
+  executeBlock(stmt.statements, std::make_shared<Environment>(environment));
   return {};
 }
 
-std::any Interpreter::visitExpressionStmt(std::shared_ptr<Expression> stmt) {
-  evaluate(stmt->expression);
+std::any Interpreter::visitExpressionStmt(Expression& stmt) {
+  evaluate(stmt.expression);
   return {};
 }
 
-std::any Interpreter::visitPrintStmt(std::shared_ptr<Print> stmt) {
-  std::any value = evaluate(stmt->expression);
-  std::cout << stringify(value) << "\n";
+std::any Interpreter::visitPrintStmt(Print& stmt) {
+  std::any value = evaluate(stmt.expression);
+  print(value);
   return {};
 }
 
-std::any Interpreter::visitVarStmt(std::shared_ptr<Var> stmt) {
+std::any Interpreter::visitVarStmt(Var& stmt) {
   std::any value = nullptr;
-  if(stmt->initializer != nullptr) {
-    value = evaluate(stmt->initializer);
+  if(stmt.initializer != nullptr) {
+    value = evaluate(stmt.initializer);
   }
-  environment->define(stmt->name.lexeme, std::move(value));
+  environment->define(stmt.name.lexeme, std::move(value));
   return {};
 }
\ No newline at end of file
@@ -1,61 +1,141 @@
 #ifndef __INTERPRETER_H
 #define __INTERPRETER_H
+#include <array>
 #include <chrono>
+#include <span>
 #include "Expr.hpp"
 #include "Stmt.hpp"
 #include "Environment.hpp"
+#include "OutputBuffer.hpp"
+
+class Lox;
+class EventLoop;
+class Jit;
+class LoxCallable;
+class LoxFunction;
+class LoxIsolate;
+class MemoCache;
 
 class Interpreter : public ExprVisitor, public StmtVisitor {
   friend class LoxFunction;
+  friend class EventLoop;
+  friend class ClosureCompiler;
+  friend class LoxIsolate;
 
 public: 
+  enum class Engine { TREE, CLOSURE };
+
+  Lox& lox;
   std::shared_ptr<Environment> globals{new Environment};
+  OutputBuffer output;
+  // How many nodes switched to each specialized variant, and how many of
+  // those later fell back to the generic one.
+  std::array<size_t, static_cast<size_t>(Specialization::COUNT)> specializedSites{};
+  size_t deoptimizedSites = 0;
+  // How interpret() runs scripts: by walking the AST with this visitor,
+  // or through closures built by the ClosureCompiler.
+  Engine engine = Engine::TREE;
+  // Whether every pure function's results are cached, rather than only
+  // those declared `pure fun`, and how that has gone so far.
+  bool memoize = false;
+  size_t memoizedFunctions = 0;
+  size_t memoRejected = 0;
+  // Caches dropped because a function they depend on was rebound.
+  size_t memoInvalidated = 0;
+  size_t memoHits = 0;
+  size_t memoMisses = 0;
 private: 
   std::shared_ptr<Environment> environment = globals; 
-  std::map<std::shared_ptr<Expr>, int> locals;
+  std::vector<const void*> printing;
+  // Created when the script first uses tasks.
+  std::unique_ptr<EventLoop> events;
+  // Only set when the JIT is enabled; worker interpreters never have one.
+  std::unique_ptr<Jit> jit;
+  // Isolates spawned by this session. A handle may never be destroyed
+  // (global functions and the globals keep each other alive), so the
+  // session closes and joins them itself; see closeIsolates.
+  std::vector<std::weak_ptr<LoxIsolate>> isolates;
+  // Workers share the AST with the main interpreter and leave the nodes'
+  // specialization state alone.
+  bool specializing = true;
 public:
 // Constructors
-  Interpreter() {}
-  ~Interpreter() = default;
+  Interpreter(Lox& lox, std::ostream& out);
+  // A worker that runs callbacks on another thread. It shares this
+  // interpreter's globals and must not write to them.
+  std::unique_ptr<Interpreter> makeWorker();
+  EventLoop& eventLoop();
+  void enableJit();
+  // Closes the channels of every isolate still running and waits for
+  // them to finish. Called when a script file ends and when the session
+  // is destroyed.
+  void closeIsolates();
+  ~Interpreter();
   Interpreter(Interpreter& other) = delete;
   Interpreter(Interpreter&& other) = delete;
   Interpreter& operator=(Interpreter& other) = delete;
 
   // Expression overrides
-  std::any visitLiteralExpr(std::shared_ptr<Literal> expr) override;
-  std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) override;
-  std::any visitUnaryExpr(std::shared_ptr<Unary> expr) override;
-  std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override;
-  std::any visitAssignExpr(std::shared_ptr<Assign> expr) override;
-  std::any visitLogicalExpr(std::shared_ptr<Logical> expr) override;
-  std::any visitVariableExpr(std::shared_ptr<Variable> expr) override;
-  std::any visitGetExpr(std::shared_ptr<Get> expr) override;
-  std::any visitSetExpr(std::shared_ptr<Set> expr) override;
-  std::any visitThisExpr(std::shared_ptr<This> expr) override;
-  std::any visitSuperExpr(std::shared_ptr<Super> expr) override;
-  std::any visitCallExpr(std::shared_ptr<Call> expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
 
   // Statement overrides
-  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override;
-  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override;
-  std::any visitIfStmt(std::shared_ptr<If> stmt) override;
-  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override;
-  std::any visitVarStmt(std::shared_ptr<Var> stmt) override;
-  std::any visitWhileStmt(std::shared_ptr<While> stmt) override;
-  std::any visitFunctionStmt(std::shared_ptr<Function> stmt) override;
-  std::any visitReturnStmt(std::shared_ptr<Return> stmt) override;
-  std::any visitClassStmt(std::shared_ptr<Class> stmt) override;
-  void interpret(std::vector<std::shared_ptr<Stmt>>& statements);
+  std::any visitBlockStmt(Block& stmt) override;
+  std::any visitExpressionStmt(Expression& stmt) override;
+  std::any visitIfStmt(If& stmt) override;
+  std::any visitPrintStmt(Print& stmt) override;
+  std::any visitVarStmt(Var& stmt) override;
+  std::any visitWhileStmt(While& stmt) override;
+  std::any visitForStmt(For& stmt) override;
+  std::any visitFunctionStmt(Function& stmt) override;
+  std::any visitReturnStmt(Return& stmt) override;
+  std::any visitClassStmt(Class& stmt) override;
+  bool interpret(const std::vector<std::shared_ptr<Stmt>>& statements);
   void executeBlock(const std::vector<std::shared_ptr<Stmt>>& statements, std::shared_ptr<Environment> environment);
-  void resolve(std::shared_ptr<Expr> expr, int depth);
 private:
   bool isTruthy(std::any& object);
+  // Skips the type test when TypeInference proved the value is a bool.
+  bool isTruthy(std::any& object, StaticType type) {
+    return type == StaticType::BOOL ? *std::any_cast<bool>(&object) : isTruthy(object);
+  }
   bool isEqual(std::any& a, std::any& b);
   std::string stringify(std::any& object);
-  std::any evaluate(std::shared_ptr<Expr> expr);
-  void execute(std::shared_ptr<Stmt> stmt);
+  void print(std::any& object);
+  std::any evaluate(const std::shared_ptr<Expr>& expr);
+  void execute(const std::shared_ptr<Stmt>& stmt);
   void checkNumberOperands(const Token& op, std::any& left, std::any& right);
-  std::any lookUpVariable(Token name, std::shared_ptr<Expr> expr);
+  size_t checkIndex(const Token& bracket, std::any& index, size_t size);
+  Interpreter(const Interpreter& parent, std::ostream& out);
+  void defineNatives();
+  std::any lookUpVariable(const Token& name, int depth);
+  // The global's cell, from `cache` when a node has already looked it up.
+  std::any* globalCell(const Token& name, std::any*& cache);
+  void observe(SpecializationState& state, Specialization seen);
+  void deoptimize(SpecializationState& state);
+  std::any call(const Token& paren, LoxCallable& function, bool native, std::span<std::any> arguments);
+  // Splices the callee into a hot monomorphic site if the Inliner can.
+  void inlineCall(Call& expr, LoxFunction& function);
+  // Whether an INLINED_CALL site still calls the function it inlined.
+  bool inlinedCalleeMatches(Call& expr);
+  // A cache for a function's results, or nullptr if they are not cached.
+  // Asked on its first call and again when the cache stops holding.
+  std::unique_ptr<MemoCache> memoCache(const LoxFunction& function);
+  std::any index(const Token& bracket, std::any& object, std::any& index);
+  void checkIndexable(const Token& bracket, std::any& object);
+  void setIndex(const Token& bracket, std::any& object, std::any& index, std::any& value);
 };
 
 #endif
\ No newline at end of file
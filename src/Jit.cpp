@@ -0,0 +1,611 @@
+#include "Jit.hpp"
+#include "Interpreter.hpp"
+#include "LoxFunction.hpp"
+#include "Environment.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <cstring>
+#include <map>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Raised while compiling when the body uses something the JIT does not
+// handle; the function is then left to the interpreter.
+struct JitUnsupported {};
+
+// Just enough of an x86-64 encoder for the templates below. Only rax,
+// rsp, rbp, rsi, rdi and xmm0/xmm1 are used, none of which need a REX
+// prefix to name.
+class Assembler {
+  struct Fixup {
+    size_t at;
+    size_t label;
+  };
+  std::vector<size_t> labels;
+  std::vector<Fixup> fixups;
+
+public:
+  static constexpr int RAX = 0, RSP = 4, RBP = 5, RSI = 6, RDI = 7;
+  // Condition codes for jcc.
+  static constexpr uint8_t BELOW = 0x2, ABOVE_EQUAL = 0x3, EQUAL = 0x4, NOT_EQUAL = 0x5,
+    BELOW_EQUAL = 0x6, ABOVE = 0x7, PARITY = 0xA;
+
+  std::vector<uint8_t> bytes;
+
+  void emit(std::initializer_list<uint8_t> code) { bytes.insert(bytes.end(), code); }
+  void emit32(uint32_t value) {
+    for(int i = 0; i < 4; i++) bytes.push_back(value >> (8 * i));
+  }
+  void emit64(uint64_t value) {
+    for(int i = 0; i < 8; i++) bytes.push_back(value >> (8 * i));
+  }
+  void patch32(size_t at, uint32_t value) {
+    for(int i = 0; i < 4; i++) bytes[at + i] = value >> (8 * i);
+  }
+
+  size_t newLabel() {
+    labels.push_back(SIZE_MAX);
+    return labels.size() - 1;
+  }
+  void bind(size_t label) { labels[label] = bytes.size(); }
+  void jump(size_t label) {
+    emit({0xE9});
+    fixups.push_back({bytes.size(), label});
+    emit32(0);
+  }
+  void jumpIf(uint8_t condition, size_t label) {
+    emit({0x0F, uint8_t(0x80 | condition)});
+    fixups.push_back({bytes.size(), label});
+    emit32(0);
+  }
+  void resolve() {
+    for(const Fixup& fixup : fixups) {
+      patch32(fixup.at, uint32_t(labels[fixup.label] - (fixup.at + 4)));
+    }
+  }
+
+  // movsd xmm, [base + offset] and movsd [base + offset], xmm.
+  void load(int xmm, int base, int32_t offset) { memory(0x10, xmm, base, offset); }
+  void store(int base, int32_t offset, int xmm) { memory(0x11, xmm, base, offset); }
+  void loadConstant(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    emit({0x48, 0xB8});  // mov rax, imm64
+    emit64(bits);
+    emit({0x66, 0x48, 0x0F, 0x6E, 0xC0});  // movq xmm0, rax
+  }
+  // Temporaries live on the native stack between the two operands.
+  void push() { emit({0x66, 0x48, 0x0F, 0x7E, 0xC0, 0x50}); }  // movq rax, xmm0; push rax
+  void popRight() {
+    emit({0x66, 0x0F, 0x28, 0xC8});  // movapd xmm1, xmm0
+    emit({0x58, 0x66, 0x48, 0x0F, 0x6E, 0xC0});  // pop rax; movq xmm0, rax
+  }
+  void arithmetic(uint8_t opcode) { emit({0xF2, 0x0F, opcode, 0xC1}); }  // op xmm0, xmm1
+  void compare(int left, int right) {  // ucomisd
+    emit({0x66, 0x0F, 0x2E, uint8_t(0xC0 | left << 3 | right)});
+  }
+  void prologue() { emit({0x55, 0x48, 0x89, 0xE5}); }  // push rbp; mov rbp, rsp
+  void epilogue() { emit({0xC9, 0xC3}); }  // leave; ret
+  void returnStatus(uint32_t status) {
+    emit({0xB8});  // mov eax, imm32
+    emit32(status);
+    epilogue();
+  }
+  // Calls through a pointer so a callee may be compiled after its caller.
+  void callIndirect(const void* const* target) {
+    emit({0x48, 0xB8});
+    emit64(reinterpret_cast<uint64_t>(target));
+    emit({0xFF, 0x10});  // call [rax]
+  }
+  void adjustStack(int32_t bytes) {
+    if(bytes == 0) return;
+    emit({0x48, 0x81, uint8_t(bytes > 0 ? 0xEC : 0xC4)});  // sub/add rsp, imm32
+    emit32(bytes > 0 ? bytes : -bytes);
+  }
+
+private:
+  void memory(uint8_t opcode, int xmm, int base, int32_t offset) {
+    emit({0xF2, 0x0F, opcode, uint8_t(0x80 | xmm << 3 | base)});
+    if(base == RSP) emit({0x24});
+    emit32(offset);
+  }
+};
+
+// Translates one function body. Every value expression leaves a number
+// in xmm0; conditions are compiled straight into jumps, so booleans never
+// need a representation of their own.
+class JitCompiler : public ExprVisitor, public StmtVisitor {
+  using A = Assembler;
+
+  Jit& jit;
+  LoxFunction& function;
+  JitCode& code;
+  // Functions compiled in this attempt and not yet committed, so that
+  // mutually recursive functions find each other.
+  std::map<const Function*, std::shared_ptr<JitCode>>& pending;
+  Assembler a;
+  // Stack slot of each local by name, one map per environment the
+  // interpreter would create (the first holds the parameters).
+  std::vector<std::map<std::string, int>> scopes;
+  int slots = 0;
+  size_t bail;
+
+public:
+  // Where the body starts in the code returned by compile(), after the
+  // entry point.
+  size_t bodyOffset = 0;
+
+  JitCompiler(Jit& jit, LoxFunction& function, JitCode& code, std::map<const Function*, std::shared_ptr<JitCode>>& pending)
+    : jit{jit}, function{function}, code{code}, pending{pending} {}
+
+  std::vector<uint8_t> compile() {
+    const Function& declaration = *function.declaration;
+    int arity = declaration.params.size();
+
+    // Entry from C++: rdi holds the boxed arguments and rsi the result.
+    size_t guardFailed = a.newLabel(), done = a.newLabel();
+    int32_t frame = (8 * arity + 8 + 15) & ~15;
+    a.prologue();
+    a.adjustStack(frame);
+    a.emit({0x48, 0x89, 0x75, 0xF8});  // mov [rbp - 8], rsi
+    for(int i = 0; i < arity; i++) {
+      a.emit({0x48, 0x83, 0xBF});  // cmp qword [rdi + 16i], 1
+      a.emit32(16 * i);
+      a.emit({1});
+      a.jumpIf(A::NOT_EQUAL, guardFailed);
+      a.load(0, A::RDI, 16 * i + 8);
+      a.store(A::RSP, 8 * i, 0);
+    }
+    a.emit({0x48, 0x89, 0xE7});  // mov rdi, rsp
+    a.callIndirect(&code.body);
+    a.emit({0x48, 0x8B, 0x75, 0xF8});  // mov rsi, [rbp - 8]
+    a.emit({0x85, 0xC0});  // test eax, eax
+    a.jumpIf(A::NOT_EQUAL, done);
+    a.emit({0xF2, 0x0F, 0x11, 0x06});  // movsd [rsi], xmm0
+    a.bind(done);
+    a.epilogue();
+    a.bind(guardFailed);
+    a.returnStatus(1);
+
+    // The body proper: rdi points at the unboxed arguments. Returns the
+    // result in xmm0 with eax 0, or eax 2 to give up.
+    size_t bodyStart = a.bytes.size();
+    bail = a.newLabel();
+    a.prologue();
+    a.emit({0x48, 0x81, 0xEC});  // sub rsp, frame
+    size_t frameSize = a.bytes.size();
+    a.emit32(0);
+    scopes.emplace_back();
+    for(const Token& param : declaration.params) {
+      int slot = declare(param.lexeme);
+      a.load(0, A::RDI, 8 * slot);
+      a.store(A::RBP, offset(slot), 0);
+    }
+    for(const std::shared_ptr<Stmt>& stmt : declaration.body) {
+      stmt->accept(*this);
+    }
+    // Falling off the end returns nil.
+    a.returnStatus(2);
+    a.bind(bail);
+    a.epilogue();
+    a.patch32(frameSize, (8 * slots + 15) & ~15);
+    a.resolve();
+
+    bodyOffset = bodyStart;
+    return std::move(a.bytes);
+  }
+
+  std::any visitBlockStmt(Block& stmt) override {
+    scopes.emplace_back();
+    for(const std::shared_ptr<Stmt>& statement : stmt.statements) {
+      statement->accept(*this);
+    }
+    scopes.pop_back();
+    return {};
+  }
+
+  std::any visitExpressionStmt(Expression& stmt) override {
+    value(stmt.expression);
+    return {};
+  }
+
+  std::any visitIfStmt(If& stmt) override {
+    size_t otherwise = a.newLabel(), end = a.newLabel();
+    branch(stmt.condition, otherwise, false);
+    stmt.thenBranch->accept(*this);
+    a.jump(end);
+    a.bind(otherwise);
+    if(stmt.elseBranch != nullptr) stmt.elseBranch->accept(*this);
+    a.bind(end);
+    return {};
+  }
+
+  std::any visitWhileStmt(While& stmt) override {
+    size_t top = a.newLabel(), end = a.newLabel();
+    a.bind(top);
+    branch(stmt.condition, end, false);
+    stmt.body->accept(*this);
+    a.jump(top);
+    a.bind(end);
+    return {};
+  }
+
+  std::any visitForStmt(For& stmt) override {
+    if(stmt.initializer != nullptr) {
+      scopes.emplace_back();
+      stmt.initializer->accept(*this);
+    }
+    size_t top = a.newLabel(), end = a.newLabel();
+    a.bind(top);
+    branch(stmt.condition, end, false);
+    stmt.body->accept(*this);
+    if(stmt.increment != nullptr) value(stmt.increment);
+    a.jump(top);
+    a.bind(end);
+    if(stmt.initializer != nullptr) scopes.pop_back();
+    return {};
+  }
+
+  std::any visitVarStmt(Var& stmt) override {
+    // An uninitialized variable holds nil.
+    if(stmt.initializer == nullptr) throw JitUnsupported{};
+    value(stmt.initializer);
+    a.store(A::RBP, offset(declare(stmt.name.lexeme)), 0);
+    return {};
+  }
+
+  std::any visitReturnStmt(Return& stmt) override {
+    if(stmt.value == nullptr) throw JitUnsupported{};
+    value(stmt.value);
+    a.emit({0x31, 0xC0});  // xor eax, eax
+    a.epilogue();
+    return {};
+  }
+
+  std::any visitPrintStmt(Print& stmt) override { throw JitUnsupported{}; }
+  std::any visitClassStmt(Class& stmt) override { throw JitUnsupported{}; }
+  std::any visitFunctionStmt(Function& stmt) override { throw JitUnsupported{}; }
+
+  std::any visitLiteralExpr(Literal& expr) override {
+    if(expr.value.type() != typeid(double)) throw JitUnsupported{};
+    a.loadConstant(std::any_cast<double>(expr.value));
+    return {};
+  }
+
+  std::any visitGroupingExpr(Grouping& expr) override {
+    value(expr.expression);
+    return {};
+  }
+
+  std::any visitUnaryExpr(Unary& expr) override {
+    if(expr.op.type != TokenType::MINUS) throw JitUnsupported{};
+    value(expr.right);
+    a.emit({0x48, 0xB8});  // flip the sign bit
+    a.emit64(0x8000000000000000ull);
+    a.emit({0x66, 0x48, 0x0F, 0x6E, 0xC8});  // movq xmm1, rax
+    a.emit({0x66, 0x0F, 0x57, 0xC1});  // xorpd xmm0, xmm1
+    return {};
+  }
+
+  std::any visitBinaryExpr(Binary& expr) override {
+    uint8_t opcode;
+    switch(expr.op.type) {
+      case TokenType::PLUS: opcode = 0x58; break;
+      case TokenType::MINUS: opcode = 0x5C; break;
+      case TokenType::STAR: opcode = 0x59; break;
+      case TokenType::SLASH: opcode = 0x5E; break;
+      default: throw JitUnsupported{};
+    }
+    operands(expr);
+    a.arithmetic(opcode);
+    return {};
+  }
+
+  std::any visitVariableExpr(Variable& expr) override {
+    a.load(0, A::RBP, offset(local(expr.name.lexeme, expr.depth)));
+    return {};
+  }
+
+  std::any visitAssignExpr(Assign& expr) override {
+    int slot = local(expr.name.lexeme, expr.depth);
+    value(expr.value);
+    a.store(A::RBP, offset(slot), 0);
+    return {};
+  }
+
+  std::any visitCallExpr(Call& expr) override {
+    auto callee = std::dynamic_pointer_cast<Variable>(expr.callee);
+    if(callee == nullptr) throw JitUnsupported{};
+    JitCode* target = resolveCallee(callee, expr.arguments.size());
+
+    int32_t frame = (8 * expr.arguments.size() + 15) & ~15;
+    a.adjustStack(frame);
+    for(size_t i = 0; i < expr.arguments.size(); i++) {
+      value(expr.arguments[i]);
+      a.store(A::RSP, 8 * i, 0);
+    }
+    a.emit({0x48, 0x89, 0xE7});  // mov rdi, rsp
+    a.callIndirect(&target->body);
+    a.adjustStack(-frame);
+    a.emit({0x85, 0xC0});  // test eax, eax
+    a.jumpIf(A::NOT_EQUAL, bail);
+    return {};
+  }
+
+  std::any visitLogicalExpr(Logical& expr) override { throw JitUnsupported{}; }
+  std::any visitGetExpr(Get& expr) override { throw JitUnsupported{}; }
+  std::any visitSetExpr(Set& expr) override { throw JitUnsupported{}; }
+  std::any visitThisExpr(This& expr) override { throw JitUnsupported{}; }
+  std::any visitSuperExpr(Super& expr) override { throw JitUnsupported{}; }
+  std::any visitIndexExpr(Index& expr) override { throw JitUnsupported{}; }
+  std::any visitSetIndexExpr(SetIndex& expr) override { throw JitUnsupported{}; }
+  std::any visitListLiteralExpr(ListLiteral& expr) override { throw JitUnsupported{}; }
+
+private:
+  void value(const std::shared_ptr<Expr>& expr) { expr->accept(*this); }
+
+  // Leaves the left operand in xmm0 and the right one in xmm1.
+  void operands(Binary& expr) {
+    value(expr.left);
+    a.push();
+    value(expr.right);
+    a.popRight();
+  }
+
+  // Jumps to `label` if the condition's truthiness equals `ifTrue`, and
+  // falls through otherwise.
+  void branch(const std::shared_ptr<Expr>& expr, size_t label, bool ifTrue) {
+    if(auto grouping = std::dynamic_pointer_cast<Grouping>(expr)) {
+      branch(grouping->expression, label, ifTrue);
+    } else if(auto literal = std::dynamic_pointer_cast<Literal>(expr)) {
+      bool truthy = true;
+      if(literal->value.type() == typeid(bool)) truthy = std::any_cast<bool>(literal->value);
+      if(truthy == ifTrue) a.jump(label);
+    } else if(auto unary = std::dynamic_pointer_cast<Unary>(expr); unary && unary->op.type == TokenType::BANG) {
+      branch(unary->right, label, !ifTrue);
+    } else if(auto logical = std::dynamic_pointer_cast<Logical>(expr)) {
+      bool isOr = logical->op.type == TokenType::OR;
+      if(isOr == ifTrue) {
+        // `a or b` is true, and `a and b` false, as soon as `a` is.
+        branch(logical->left, label, ifTrue);
+        branch(logical->right, label, ifTrue);
+      } else {
+        size_t skip = a.newLabel();
+        branch(logical->left, skip, isOr);
+        branch(logical->right, label, ifTrue);
+        a.bind(skip);
+      }
+    } else if(auto binary = std::dynamic_pointer_cast<Binary>(expr); binary && isComparison(binary->op.type)) {
+      comparison(*binary, label, ifTrue);
+    } else {
+      // Numbers are always truthy.
+      value(expr);
+      if(ifTrue) a.jump(label);
+    }
+  }
+
+  static bool isComparison(TokenType type) {
+    return type == TokenType::GREATER || type == TokenType::GREATER_EQUAL || type == TokenType::LESS
+      || type == TokenType::LESS_EQUAL || type == TokenType::EQUAL_EQUAL || type == TokenType::BANG_EQUAL;
+  }
+
+  void comparison(Binary& expr, size_t label, bool ifTrue) {
+    // ucomisd sets CF, ZF and PF together when either side is NaN, so
+    // ordering tests use ABOVE/ABOVE_EQUAL with the operands arranged to
+    // come out false, and equality checks PF separately.
+    switch(expr.op.type) {
+      case TokenType::GREATER:
+      case TokenType::GREATER_EQUAL:
+      case TokenType::LESS:
+      case TokenType::LESS_EQUAL: {
+        bool strict = expr.op.type == TokenType::GREATER || expr.op.type == TokenType::LESS;
+        bool swapped = expr.op.type == TokenType::LESS || expr.op.type == TokenType::LESS_EQUAL;
+        operands(expr);
+        swapped ? a.compare(1, 0) : a.compare(0, 1);
+        if(ifTrue) a.jumpIf(strict ? A::ABOVE : A::ABOVE_EQUAL, label);
+        else a.jumpIf(strict ? A::BELOW_EQUAL : A::BELOW, label);
+        return;
+      }
+      case TokenType::EQUAL_EQUAL:
+      case TokenType::BANG_EQUAL: {
+        operands(expr);
+        a.compare(0, 1);
+        if(ifTrue == (expr.op.type == TokenType::EQUAL_EQUAL)) {
+          size_t skip = a.newLabel();
+          a.jumpIf(A::PARITY, skip);
+          a.jumpIf(A::EQUAL, label);
+          a.bind(skip);
+        } else {
+          a.jumpIf(A::PARITY, label);
+          a.jumpIf(A::NOT_EQUAL, label);
+        }
+        return;
+      }
+    }
+  }
+
+  int declare(const std::string& name) {
+    scopes.back()[name] = slots;
+    return slots++;
+  }
+
+  static int32_t offset(int slot) { return -8 * (slot + 1); }
+
+  // Finds a local's slot, checking that it is the variable the resolver
+  // picked. Anything else is a global or a captured variable, which
+  // compiled code cannot read.
+  int local(const std::string& name, int depth) {
+    for(int i = scopes.size() - 1; i >= 0; i--) {
+      auto found = scopes[i].find(name);
+      if(found == scopes[i].end()) continue;
+      if(depth != int(scopes.size()) - 1 - i) throw JitUnsupported{};
+      return found->second;
+    }
+    throw JitUnsupported{};
+  }
+
+  JitCode* resolveCallee(const std::shared_ptr<Variable>& callee, size_t arity) {
+    int depth = scopes.size() - 1;
+    // A local may hold any function by the time it is called.
+    if(callee->depth >= 0 && callee->depth <= depth) throw JitUnsupported{};
+    JitCode::Callee target{callee->name.lexeme, callee->depth < 0 ? -1 : callee->depth - depth - 1, {}};
+
+    std::any* found = jit.lookUp(function, target);
+    if(found == nullptr || found->type() != typeid(std::shared_ptr<LoxFunction>)) throw JitUnsupported{};
+    auto& other = std::any_cast<std::shared_ptr<LoxFunction>&>(*found);
+    if(other->isInitializer || other->declaration->params.size() != arity) throw JitUnsupported{};
+    const Function* declaration = other->declaration.get();
+    target.declaration = other->declaration;
+
+    bool known = false;
+    for(const JitCode::Callee& existing : code.callees) {
+      known = known || (existing.name == target.name && existing.distance == target.distance);
+    }
+    if(!known) code.callees.push_back(target);
+
+    if(declaration->jitCode != nullptr) return declaration->jitCode.get();
+    if(declaration->jitFailed) throw JitUnsupported{};
+    auto compiling = pending.find(declaration);
+    if(compiling != pending.end()) return compiling->second.get();
+    JitCode* compiled = jit.compile(*other);
+    if(compiled == nullptr) throw JitUnsupported{};
+    return compiled;
+  }
+};
+
+Jit::Jit(Interpreter& interpreter)
+  : interpreter{interpreter} {}
+
+Jit::~Jit() = default;
+
+JitCode::~JitCode() {
+  if(memory != nullptr) munmap(memory, size);
+}
+
+// Functions compiled while compiling the one that got hot. They are only
+// attached to their declarations once everything they call compiled too;
+// until then the attempt owns their code.
+static thread_local std::map<const Function*, std::shared_ptr<JitCode>>* pending = nullptr;
+
+JitCode* Jit::compile(LoxFunction& function) {
+  bool outermost = pending == nullptr;
+  std::map<const Function*, std::shared_ptr<JitCode>> attempt;
+  if(outermost) pending = &attempt;
+  auto code = std::make_shared<JitCode>();
+  JitCode* result = code.get();
+  (*pending)[function.declaration.get()] = code;
+  std::vector<uint8_t> bytes;
+  size_t bodyOffset = 0;
+  try {
+    JitCompiler compiler{*this, function, *code, *pending};
+    bytes = compiler.compile();
+    bodyOffset = compiler.bodyOffset;
+  } catch(JitUnsupported&) {
+    result = nullptr;
+  }
+
+  if(result != nullptr) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = (bytes.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED) {
+      result = nullptr;
+    } else {
+      std::memcpy(memory, bytes.data(), bytes.size());
+      code->memory = memory;
+      code->size = size;
+      // The pages are unmapped with `code` if they cannot be made
+      // executable.
+      if(mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        result = nullptr;
+      } else {
+        code->entry = reinterpret_cast<int (*)(const JitValue*, double*)>(memory);
+        code->body = static_cast<char*>(memory) + bodyOffset;
+      }
+    }
+  }
+  if(result == nullptr) pending->erase(function.declaration.get());
+
+  if(!outermost) return result;
+  pending = nullptr;
+  if(result == nullptr) {
+    // Everything this attempt produced is dropped with it; the callees
+    // may still compile later on their own.
+    function.declaration->jitFailed = true;
+    return nullptr;
+  }
+  for(auto& [declaration, compiledCode] : attempt) {
+    const_cast<Function*>(declaration)->jitCode = compiledCode;
+  }
+  return result;
+}
+
+std::any* Jit::lookUp(const LoxFunction& function, const JitCode::Callee& callee) {
+  if(callee.distance < 0) return interpreter.globals->find(callee.name);
+  return function.closure->ancestor(callee.distance)->find(callee.name);
+}
+
+bool Jit::calleesHold(const LoxFunction& function, std::vector<const LoxFunction*>& checked) {
+  for(const LoxFunction* seen : checked) {
+    if(seen == &function) return true;
+  }
+  checked.push_back(&function);
+  for(const JitCode::Callee& callee : function.declaration->jitCode->callees) {
+    std::any* found = lookUp(function, callee);
+    if(found == nullptr || found->type() != typeid(std::shared_ptr<LoxFunction>)) return false;
+    auto& other = std::any_cast<std::shared_ptr<LoxFunction>&>(*found);
+    if(other->declaration != callee.declaration.lock()) return false;
+    if(!calleesHold(*other, checked)) return false;
+  }
+  return true;
+}
+
+bool Jit::call(LoxFunction& function, std::span<std::any> arguments, std::any& result) {
+  Function& declaration = *function.declaration;
+  if(function.isInitializer || declaration.jitFailed) return false;
+  if(declaration.jitCode == nullptr && compile(function) == nullptr) return false;
+
+  std::vector<const LoxFunction*> checked;
+  if(!calleesHold(function, checked)) return false;
+
+  std::vector<JitValue> values(arguments.size());
+  for(size_t i = 0; i < arguments.size(); i++) {
+    if(arguments[i].type() == typeid(double)) values[i] = {1, std::any_cast<double>(arguments[i])};
+    else values[i] = {0, 0};
+  }
+  double number;
+  int status = declaration.jitCode->entry(values.data(), &number);
+  if(status == 0) {
+    result = number;
+    return true;
+  }
+  if(status == 2) declaration.jitFailed = true;
+  return false;
+}
+
+#else
+
+Jit::Jit(Interpreter& interpreter)
+  : interpreter{interpreter} {}
+
+Jit::~Jit() = default;
+
+JitCode::~JitCode() = default;
+
+JitCode* Jit::compile(LoxFunction& function) {
+  return nullptr;
+}
+
+bool Jit::calleesHold(const LoxFunction& function, std::vector<const LoxFunction*>& checked) {
+  return false;
+}
+
+std::any* Jit::lookUp(const LoxFunction& function, const JitCode::Callee& callee) {
+  return nullptr;
+}
+
+bool Jit::call(LoxFunction& function, std::span<std::any> arguments, std::any& result) {
+  return false;
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef __JIT_H
+#define __JIT_H
+
+#include <any>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+class Interpreter;
+class LoxFunction;
+struct Function;
+
+// How the interpreter passes an argument to compiled code. The entry
+// point checks `isNumber` before touching `number`.
+struct JitValue {
+  uint64_t isNumber;
+  double number;
+};
+
+// Native code for one function body, shared by every LoxFunction created
+// from the same declaration.
+struct JitCode {
+  // A function the body calls directly. Before entering compiled code
+  // from the interpreter, `name` must still resolve to a function with
+  // this declaration; `distance` counts environments from the caller's
+  // closure, -1 meaning a global. The compiled call reads the callee's
+  // JitCode, which lives as long as its declaration; the weak reference
+  // tells a freed declaration from a new one at the same address.
+  struct Callee {
+    std::string name;
+    int distance;
+    std::weak_ptr<Function> declaration;
+  };
+
+  // Called from C++. Returns 0 with the result stored, 1 if an argument
+  // is not a number or 2 if the body reached code it cannot run natively.
+  int (*entry)(const JitValue* arguments, double* result) = nullptr;
+  // Called from compiled code with the arguments already unboxed.
+  const void* body = nullptr;
+  std::vector<Callee> callees;
+  void* memory = nullptr;
+  size_t size = 0;
+
+  JitCode() = default;
+  JitCode(JitCode& other) = delete;
+  JitCode& operator=(JitCode& other) = delete;
+  ~JitCode();
+};
+
+// Baseline compiler from Lox function bodies to x86-64 machine code,
+// enabled with --jit. Once a function has been called hotCalls times its
+// body is translated statement by statement into code that keeps numbers
+// unboxed on the native stack.
+//
+// Only functions that work purely on numbers are compiled: parameters and
+// locals, arithmetic, comparisons, if/while/for, and calls to themselves
+// or to other such functions. Compiled code has no side effects visible to
+// the script, so whenever it cannot continue (an argument is not a number,
+// a callee was reassigned, the body ends without returning a number) the
+// whole call simply runs again in the interpreter. A body that gives up
+// once is not entered again.
+//
+// On other platforms the compiler is absent and every call is
+// interpreted.
+class Jit {
+  friend class JitCompiler;
+
+  Interpreter& interpreter;
+
+public:
+  static constexpr unsigned hotCalls = 10;
+
+  Jit(Interpreter& interpreter);
+  Jit(Jit& other) = delete;
+  Jit& operator=(Jit& other) = delete;
+  ~Jit();
+
+  // Runs the call natively if it can. Returns false, leaving the call to
+  // the interpreter, if the function cannot be compiled or a guard fails.
+  bool call(LoxFunction& function, std::span<std::any> arguments, std::any& result);
+
+private:
+  JitCode* compile(LoxFunction& function);
+  bool calleesHold(const LoxFunction& function, std::vector<const LoxFunction*>& checked);
+  std::any* lookUp(const LoxFunction& function, const JitCode::Callee& callee);
+};
+
+#endif
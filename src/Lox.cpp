@@ -3,14 +3,12 @@
 #include <filesystem>
 #include <exception>
 #include "Lox.hpp"
-#include "AstPrinter.hpp"
+#include "ParallelScanner.hpp"
 #include "Parser.hpp"
 #include "Interpreter.hpp"
-#include "Resolver.hpp"
-
-bool Lox::hadError = false;
-bool Lox::hadRuntimeError = false;
-Interpreter Lox::interpreter = Interpreter();
+#include "AstStats.hpp"
+#include "TypeInference.hpp"
+#include "CppEmitter.hpp"
 
 std::string Lox::fileContentsToString(std::string filePath) {
   std::ifstream t(filePath);
@@ -20,72 +18,139 @@ std::string Lox::fileContentsToString(std::string filePath) {
 }
 
 void Lox::run(std::string contents) {
-  Scanner scanner = Scanner(contents);
+  std::shared_ptr<LoxProgram> program = compile(std::move(contents));
+  if(program) program->run();
+}
+
+std::shared_ptr<LoxProgram> Lox::compile(std::string source) {
+  // hadError stays set for the session; only this script's errors decide
+  // whether it compiles.
+  bool hadEarlierError = hadError;
+  hadError = false;
+  ParallelScanner scanner = ParallelScanner(*this, std::move(source));
   std::vector<Token>& tokens = scanner.scanTokens();
 
-  Parser parser = Parser(tokens);
+  // The parser resolves local variables as it builds the tree.
+  Parser parser = Parser(*this, tokens, interpreter);
   std::vector<std::shared_ptr<Stmt>> statements = parser.parse();
-  if(Lox::hadError) return;
+  bool failed = hadError;
+  hadError = hadError || hadEarlierError;
+  if(failed) return nullptr;
 
-  Resolver resolver = Resolver(interpreter);
-  resolver.resolve(statements);
-
-  if(Lox::hadError) return;
+  TypeInference types = TypeInference::prove(statements);
+  typeChecks = types.checks;
+  typeChecksEliminated = types.eliminated;
+  return std::make_shared<LoxProgram>(*this, std::move(statements));
+}
 
-  interpreter.interpret(statements);
+bool Lox::execute(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  return interpreter.interpret(statements);
 }
 
-void Lox::runFile(std::string filePath) {
+int Lox::runFile(std::string filePath) {
   // Check if file exists
   if(!std::filesystem::exists(filePath)) 
     throw std::runtime_error("File does not exist at " + filePath);
   // Get file contents 
   std::string fileContents = Lox::fileContentsToString(filePath);
   // run
-  Lox::run(fileContents);
-  if(Lox::hadError) exit(65);
-  if(Lox::hadRuntimeError) exit(70);
+  run(fileContents);
+  flush();
+  interpreter.closeIsolates();
+  if(showStats) printStats();
+  if(hadError) return 65;
+  if(hadRuntimeError) return 70;
+  return 0;
+}
+
+int Lox::emitCpp(std::string filePath) {
+  if(!std::filesystem::exists(filePath))
+    throw std::runtime_error("File does not exist at " + filePath);
+  std::shared_ptr<LoxProgram> program = compile(Lox::fileContentsToString(filePath));
+  if(program == nullptr) return 65;
+  CppEmitter emitter(*this, *interpreter.globals);
+  std::string code = emitter.emit(program->statements, std::filesystem::path(filePath).filename().string());
+  if(hadError) return 65;
+  interpreter.output.write(code);
+  flush();
+  return 0;
 }
 
 void Lox::runPrompt() {
   std::string line;
   while(true) {
+    flush();
     std::cout << "> ";
     std::getline(std::cin, line);
     if(line == "" || (line == "exit" || line == "quit")) {
       break;
     }
-    Lox::run(line);
+    run(line);
     hadError = false;
+    if(showStats) {
+      flush();
+      printStats();
+    }
   }
 }
 
 void Lox::report(int line, std::string where, std::string message) {
-  std::cerr << "[line " << line << "] Error" << where << ": " << message << "\n";
-  Lox::hadError = true;
+  flush();
+  err << "[line " << line << "] Error" << where << ": " << message << "\n";
+  hadError = true;
 }
 
 void Lox::error(int line, std::string message) {
-  Lox::report(line, "", message);
+  report(line, "", message);
 }
 
 void Lox::error(const Token& token, const std::string& message) {
   if(token.type == TokenType::END_OF_FILE) {
-    Lox::report(token.line, " at end", message);
+    report(token.line, " at end", message);
   } else {
-    Lox::report(token.line, " at '" + token.lexeme + "'", message);
+    report(token.line, " at '" + token.lexeme + "'", message);
   }
 }
 
-void Lox::error(Token& token, const std::string& message) {
-  if(token.type == TokenType::END_OF_FILE) {
-    Lox::report(token.line, " at end", message);
-  } else {
-    Lox::report(token.line, " at '" + token.lexeme + "'", message);
+void Lox::printStats() {
+  AstStats ast = AstStats::measure(*interpreter.globals);
+  err << "[stats] retained AST: " << ast.bytes << " bytes in " << ast.nodes << " nodes\n";
+  size_t specialized = 0;
+  std::string variants;
+  for(size_t i = 0; i < interpreter.specializedSites.size(); i++) {
+    size_t sites = interpreter.specializedSites[i];
+    if(sites == 0) continue;
+    specialized += sites;
+    variants += std::string(variants.empty() ? " (" : ", ") + specializationName(static_cast<Specialization>(i)) + " " + std::to_string(sites);
+  }
+  if(!variants.empty()) variants += ")";
+  err << "[stats] specialized sites: " << specialized << variants << ", deoptimized: " << interpreter.deoptimizedSites << "\n";
+  size_t percent = typeChecks == 0 ? 0 : typeChecksEliminated * 100 / typeChecks;
+  err << "[stats] type checks eliminated: " << typeChecksEliminated << " of " << typeChecks << " (" << percent << "%)\n";
+  if(interpreter.memoize || interpreter.memoizedFunctions + interpreter.memoRejected > 0) {
+    err << "[stats] memoized functions: " << interpreter.memoizedFunctions << " (" << interpreter.memoRejected << " not pure)"
+        << ", caches dropped: " << interpreter.memoInvalidated << ", cache hits: " << interpreter.memoHits << ", misses: " << interpreter.memoMisses << "\n";
   }
 }
 
+void Lox::define(const std::string& name, std::any value) {
+  interpreter.globals->define(name, std::move(value));
+}
+
 void Lox::runtimeError(RuntimeError& error) {
-  std::cerr << error.what() << "\n[line " << error.token.line << "]\n";
+  flush();
+  err << error.what() << "\n[line " << error.token.line << "]\n";
   hadRuntimeError = true;
+}
+
+void Lox::setLineBuffered(bool enabled) {
+  interpreter.output.setLineBuffered(enabled);
+}
+
+void Lox::setJit(bool enabled) {
+  if(enabled) interpreter.enableJit();
+}
+
+void Lox::flush() {
+  interpreter.output.flush();
 }
\ No newline at end of file
@@ -1,26 +1,74 @@
 #ifndef __LOX_HPP
 #define __LOX_HPP
+#include <iostream>
+#include <memory>
 #include <string>
 #include "Scanner.hpp"
 #include "RuntimeError.hpp"
 #include "Interpreter.hpp"
+#include "LoxProgram.hpp"
 
+// One interpreter session. It owns the interpreter, the error flags and
+// the streams output and errors are written to, and shares no mutable
+// state with other sessions, so independent sessions can run scripts
+// concurrently on different threads.
 class Lox {
-  static Interpreter interpreter;
-  static bool hadError; 
-  static bool hadRuntimeError;
-  Lox() = delete;
+  friend class LoxProgram;
+  friend class LoxEntryPoint;
+
+  std::ostream& err;
+  Interpreter interpreter;
+  bool hadError = false;
+  bool hadRuntimeError = false;
+  bool showStats = false;
+  // Type checks in the last compiled script, and how many of them the
+  // TypeInference pass removed.
+  size_t typeChecks = 0;
+  size_t typeChecksEliminated = 0;
 
 public:
+  Lox()
+    : Lox(std::cout, std::cerr) {}
+  Lox(std::ostream& out, std::ostream& err)
+    : err{err}, interpreter{*this, out} {}
+  Lox(Lox& other) = delete;
+  Lox(Lox&& other) = delete;
+  Lox& operator=(Lox& other) = delete;
+
   static std::string fileContentsToString(std::string filePath);
-  static void run(std::string fileContents);
-  static void runFile(std::string filePath);
-  static void runPrompt();
-  static void report(int line, std::string where, std::string message);
-  static void error(int line, std::string message);
-  static void error(Token& token, const std::string& message);
-  static void error(const Token& token, const std::string& message);
-  static void runtimeError(RuntimeError& error);
+  void run(std::string fileContents);
+  // Scans, parses and resolves a script without running it. Returns
+  // nullptr after reporting if the script has static errors.
+  std::shared_ptr<LoxProgram> compile(std::string source);
+  bool execute(const std::vector<std::shared_ptr<Stmt>>& statements);
+  // Returns the process exit status: 0, 65 for static errors or 70 for
+  // runtime errors.
+  int runFile(std::string filePath);
+  // Writes a C++ program equivalent to the script to the session's
+  // output instead of running it. Returns 0, or 65 if the script has
+  // static errors or uses something the C++ runtime does not have.
+  int emitCpp(std::string filePath);
+  void runPrompt();
+  void report(int line, std::string where, std::string message);
+  void error(int line, std::string message);
+  void error(const Token& token, const std::string& message);
+  void runtimeError(RuntimeError& error);
+  // Defines a global in this session, for hosts that pass values in
+  // before running a script.
+  void define(const std::string& name, std::any value);
+  void setLineBuffered(bool enabled);
+  // Prints memory, node specialization and type check statistics after
+  // each REPL line and after a file runs.
+  void setStats(bool enabled) { showStats = enabled; }
+  // Compiles hot functions to native code where the platform allows it.
+  void setJit(bool enabled);
+  // Caches the results of every function PurityChecker finds pure, not
+  // only those declared `pure fun`.
+  void setMemoize(bool enabled) { interpreter.memoize = enabled; }
+  void setEngine(Interpreter::Engine engine) { interpreter.engine = engine; }
+  void printStats();
+  void flush();
+  bool failed() { return hadError || hadRuntimeError; }
 };
 
-#endif
\ No newline at end of file
+#endif
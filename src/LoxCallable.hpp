@@ -2,17 +2,47 @@
 #define __LOXCALLABLE_H
 
 #include <any>
+#include <span>
 #include <vector>
 #include <memory>
 #include <string>
 #include "Interpreter.hpp"
 
+// Callables get their arguments as a span of the caller's values, which
+// they may overwrite. A LoxFunction binds its parameters to the span
+// itself when nothing in its body can outlive the call.
 class LoxCallable {
 public:
   virtual int arity() = 0;
-  virtual std::any call(Interpreter& interpreter, std::vector<std::any>&& arguments) = 0;
+  virtual std::any call(Interpreter& interpreter, std::span<std::any> arguments) = 0;
   virtual std::string toString() = 0;
   virtual ~LoxCallable() = default;
 };
 
-#endif
\ No newline at end of file
+// The arguments of a call, evaluated into the caller's C++ frame. Calls
+// with up to `inlineCount` arguments do not touch the heap. Tasks run on
+// stacks of their own and can be suspended in the middle of a call, so
+// each frame keeps its own arguments rather than sharing one stack.
+class CallArguments {
+  static constexpr size_t inlineCount = 6;
+  std::any inlineValues[inlineCount];
+  std::vector<std::any> overflow;
+  std::span<std::any> values;
+public:
+  explicit CallArguments(size_t count) {
+    if(count <= inlineCount) {
+      values = std::span<std::any>(inlineValues, count);
+    } else {
+      overflow.resize(count);
+      values = overflow;
+    }
+  }
+  CallArguments(const CallArguments&) = delete;
+  CallArguments& operator=(const CallArguments&) = delete;
+
+  std::any& operator[](size_t i) { return values[i]; }
+  size_t size() const { return values.size(); }
+  std::span<std::any> span() { return values; }
+};
+
+#endif
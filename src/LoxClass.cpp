@@ -20,11 +20,11 @@ std::string LoxClass::toString() {
   return name;
 }
 
-std::any LoxClass::call(Interpreter& interpreter, std::vector<std::any>&& arguments) {
+std::any LoxClass::call(Interpreter& interpreter, std::span<std::any> arguments) {
   auto instance = std::make_shared<LoxInstance>(shared_from_this());
   std::shared_ptr<LoxFunction> initializer = findMethod("init");
   if(initializer != nullptr) {
-    initializer->bind(instance)->call(interpreter, std::move(arguments));
+    initializer->bind(instance)->call(interpreter, arguments);
   }
   return instance;
 }
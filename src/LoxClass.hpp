@@ -13,6 +13,7 @@ class LoxFunction;
 
 class LoxClass : public LoxCallable, public std::enable_shared_from_this<LoxClass> {
   friend class LoxInstance;
+  friend class AstStats;
   std::string name;
   std::shared_ptr<LoxClass> superClass;
   std::map <std::string, std::shared_ptr<LoxFunction>> methods;
@@ -22,7 +23,7 @@ public:
   {}
   std::shared_ptr<LoxFunction> findMethod(std::string name);
   std::string toString() override;
-  std::any call(Interpreter& interpreter, std::vector<std::any>&& arguments) override;
+  std::any call(Interpreter& interpreter, std::span<std::any> arguments) override;
   int arity() override;
 };
 
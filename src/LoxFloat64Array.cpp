@@ -0,0 +1,136 @@
+#include <cmath>
+#include <new>
+#include "LoxFloat64Array.hpp"
+#include "Float64Kernels.hpp"
+#include "LoxNative.hpp"
+#include "LoxString.hpp"
+#include "Environment.hpp"
+
+static std::shared_ptr<LoxFloat64Array> asArray(std::any& value, const std::string& function) {
+  if(value.type() != typeid(std::shared_ptr<LoxFloat64Array>)) {
+    throw NativeError("Argument to '" + function + "' must be a Float64Array.");
+  }
+  return std::any_cast<std::shared_ptr<LoxFloat64Array>>(value);
+}
+
+static double asNumber(std::any& value, const std::string& function) {
+  if(value.type() != typeid(double)) {
+    throw NativeError("Argument to '" + function + "' must be a number.");
+  }
+  return std::any_cast<double>(value);
+}
+
+static void checkSameLength(LoxFloat64Array& a, LoxFloat64Array& b, const std::string& function) {
+  if(a.elements.size() != b.elements.size()) {
+    throw NativeError("Arrays passed to '" + function + "' must have the same length.");
+  }
+}
+
+static void checkNotEmpty(LoxFloat64Array& a, const std::string& function) {
+  if(a.elements.empty()) {
+    throw NativeError("Array passed to '" + function + "' must not be empty.");
+  }
+}
+
+void LoxFloat64Array::defineNatives(Environment& globals) {
+  const Float64Kernels& kernels = Float64Kernels::get();
+
+  globals.define("Float64Array", std::make_shared<LoxNative>("Float64Array", 1, LoxNative::pure,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      double length = asNumber(arguments[0], "Float64Array");
+      if(length < 0 || length != std::floor(length)) {
+        throw NativeError("Float64Array length must be a non-negative integer.");
+      }
+      // Checked before the conversion, which is undefined for lengths
+      // beyond size_t.
+      if(length > static_cast<double>(std::vector<double>().max_size())) {
+        throw NativeError("Float64Array length is too large.");
+      }
+      try {
+        return std::make_shared<LoxFloat64Array>(static_cast<size_t>(length));
+      } catch(std::bad_alloc&) {
+        throw NativeError("Float64Array length is too large.");
+      }
+    }));
+
+  globals.define("fill", std::make_shared<LoxNative>("fill", 2,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "fill");
+      double value = asNumber(arguments[1], "fill");
+      std::fill(a->elements.begin(), a->elements.end(), value);
+      return a;
+    }));
+
+  globals.define("sum", std::make_shared<LoxNative>("sum", 1, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "sum");
+      return kernels.sum(a->elements.data(), a->elements.size());
+    }));
+
+  globals.define("dot", std::make_shared<LoxNative>("dot", 2, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "dot");
+      std::shared_ptr<LoxFloat64Array> b = asArray(arguments[1], "dot");
+      checkSameLength(*a, *b, "dot");
+      return kernels.dot(a->elements.data(), b->elements.data(), a->elements.size());
+    }));
+
+  globals.define("scale", std::make_shared<LoxNative>("scale", 2, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "scale");
+      double k = asNumber(arguments[1], "scale");
+      auto result = std::make_shared<LoxFloat64Array>(a->elements.size());
+      kernels.scale(a->elements.data(), k, result->elements.data(), a->elements.size());
+      return result;
+    }));
+
+  globals.define("add", std::make_shared<LoxNative>("add", 2, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "add");
+      std::shared_ptr<LoxFloat64Array> b = asArray(arguments[1], "add");
+      checkSameLength(*a, *b, "add");
+      auto result = std::make_shared<LoxFloat64Array>(a->elements.size());
+      kernels.add(a->elements.data(), b->elements.data(), result->elements.data(), a->elements.size());
+      return result;
+    }));
+
+  globals.define("min", std::make_shared<LoxNative>("min", 1, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "min");
+      checkNotEmpty(*a, "min");
+      return kernels.min(a->elements.data(), a->elements.size());
+    }));
+
+  globals.define("max", std::make_shared<LoxNative>("max", 1, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "max");
+      checkNotEmpty(*a, "max");
+      return kernels.max(a->elements.data(), a->elements.size());
+    }));
+
+  globals.define("prefixSum", std::make_shared<LoxNative>("prefixSum", 1, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "prefixSum");
+      auto result = std::make_shared<LoxFloat64Array>(a->elements.size());
+      kernels.prefixSum(a->elements.data(), result->elements.data(), a->elements.size());
+      return result;
+    }));
+
+  globals.define("map", std::make_shared<LoxNative>("map", 2, LoxNative::pure,
+    [&kernels](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxFloat64Array> a = asArray(arguments[0], "map");
+      if(arguments[1].type() != typeid(std::shared_ptr<LoxString>)) {
+        throw NativeError("Operation passed to 'map' must be a string.");
+      }
+      const std::string& name = std::any_cast<std::shared_ptr<LoxString>&>(arguments[1])->str();
+      Float64Kernels::UnaryOp op;
+      if(name == "abs") op = Float64Kernels::UnaryOp::ABS;
+      else if(name == "neg") op = Float64Kernels::UnaryOp::NEG;
+      else if(name == "sqrt") op = Float64Kernels::UnaryOp::SQRT;
+      else if(name == "square") op = Float64Kernels::UnaryOp::SQUARE;
+      else throw NativeError("Unknown operation '" + name + "' passed to 'map'.");
+      auto result = std::make_shared<LoxFloat64Array>(a->elements.size());
+      kernels.map(a->elements.data(), op, result->elements.data(), a->elements.size());
+      return result;
+    }));
+}
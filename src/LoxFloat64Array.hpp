@@ -0,0 +1,21 @@
+#ifndef __LOXFLOAT64ARRAY_H
+#define __LOXFLOAT64ARRAY_H
+
+#include <memory>
+#include <vector>
+
+class Environment;
+
+// Fixed-length array of unboxed doubles. Whole-array operations run as
+// native kernels (see Float64Kernels) instead of interpreted loops.
+class LoxFloat64Array {
+public:
+  std::vector<double> elements;
+
+  LoxFloat64Array(size_t length)
+    : elements(length, 0.0) {}
+
+  static void defineNatives(Environment& globals);
+};
+
+#endif
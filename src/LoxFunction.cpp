@@ -2,6 +2,8 @@
 #include "Stmt.hpp"
 #include "LoxReturn.hpp"
 #include "LoxInstance.hpp"
+#include "Jit.hpp"
+#include "ClosureCompiler.hpp"
 
 std::string LoxFunction::toString() {
   return "<fn " + declaration->name.lexeme + ">"; 
@@ -11,14 +13,70 @@ int LoxFunction::arity() {
   return declaration->params.size();
 }
 
-std::any LoxFunction::call(Interpreter& interpreter, std::vector<std::any>&& arguments) {
-  std::shared_ptr<Environment> environment = std::make_shared<Environment>(closure);
-  for(int i = 0; i < declaration->params.size(); i++) {
-    environment->define(declaration->params.at(i).lexeme, arguments.at(i));
+std::any LoxFunction::call(Interpreter& interpreter, std::span<std::any> arguments) {
+  if(interpreter.specializing) {
+    if(!memoChecked) {
+      memoChecked = true;
+      memo = interpreter.memoCache(*this);
+    }
+    if(memo != nullptr && !memo->calleesHold()) {
+      // Something it calls was rebound; the new callee may not even be
+      // pure.
+      interpreter.memoInvalidated++;
+      memo = interpreter.memoCache(*this);
+    }
+    if(memo != nullptr) return callMemoized(interpreter, arguments);
   }
 
+  if(interpreter.jit != nullptr) {
+    if(calls < Jit::hotCalls) {
+      calls++;
+    } else {
+      std::any result;
+      if(interpreter.jit->call(*this, arguments, result)) return result;
+    }
+  }
+  return invoke(interpreter, arguments);
+}
+
+// Runs the body itself, not compiled code, so that recursive calls come
+// back through the cache.
+std::any LoxFunction::callMemoized(Interpreter& interpreter, std::span<std::any> arguments) {
+  uint64_t hash;
+  if(!MemoCache::hash(arguments, hash)) return invoke(interpreter, arguments);
+  if(const std::any* result = memo->find(arguments, hash)) {
+    interpreter.memoHits++;
+    return *result;
+  }
+  interpreter.memoMisses++;
+  // The body may assign to its parameters, which live in `arguments`.
+  std::vector<std::any> key(arguments.begin(), arguments.end());
+  std::any result = invoke(interpreter, arguments);
+  memo->insert(std::move(key), hash, result);
+  return result;
+}
+
+std::any LoxFunction::invoke(Interpreter& interpreter, std::span<std::any> arguments) {
+  if(declaration->declaresClosures) {
+    std::shared_ptr<Environment> environment = std::make_shared<Environment>(closure);
+    for(int i = 0; i < declaration->params.size(); i++) {
+      environment->define(declaration->params[i].lexeme, arguments[i]);
+    }
+    return run(interpreter, std::move(environment));
+  }
+  // Nothing can keep this call's environment once it returns, so it lives
+  // on this frame, unowned, and its parameters are the caller's arguments.
+  Environment frame(closure, declaration->params, arguments);
+  return run(interpreter, std::shared_ptr<Environment>(std::shared_ptr<Environment>(), &frame));
+}
+
+std::any LoxFunction::run(Interpreter& interpreter, std::shared_ptr<Environment> environment) {
   try {
-    interpreter.executeBlock(declaration->body, environment);
+    if(declaration->closureBody != nullptr) {
+      ClosureCompiler::executeBlock(interpreter, declaration->closureBody->statements, std::move(environment));
+    } else {
+      interpreter.executeBlock(declaration->body, std::move(environment));
+    }
   } catch (LoxReturn& returnValue) {
     if(isInitializer) return closure->getAt(0, "this");
     return returnValue.value;
@@ -30,5 +88,8 @@ std::any LoxFunction::call(Interpreter& interpreter, std::vector<std::any>&& arg
 std::shared_ptr<LoxFunction> LoxFunction::bind(std::shared_ptr<LoxInstance> instance) {
   auto environment = std::make_shared<Environment>(closure);
   environment->define("this", instance);
-  return std::make_shared<LoxFunction>(declaration, environment, isInitializer);
+  auto method = std::make_shared<LoxFunction>(declaration, environment, isInitializer);
+  // Each access binds a new function, so a cache would never be reused.
+  method->memoChecked = true;
+  return method;
 }
\ No newline at end of file
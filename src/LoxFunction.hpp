@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 #include "LoxCallable.hpp"
+#include "MemoCache.hpp"
 
 struct Environment;
 struct Function;
@@ -14,9 +15,21 @@ struct LoxInstance;
 
 
 class LoxFunction : public LoxCallable{
+  friend class PurityChecker;
+  friend class AstStats;
+  friend class Jit;
+  friend class JitCompiler;
+  friend class Interpreter;
+
   std::shared_ptr<Function> declaration;
   std::shared_ptr<Environment> closure;
   bool isInitializer;
+  // Calls so far, counted up to Jit::hotCalls when the JIT is enabled.
+  unsigned calls = 0;
+  // Set on the first call if the interpreter memoizes this function.
+  // Workers neither decide this nor use the cache.
+  bool memoChecked = false;
+  std::unique_ptr<MemoCache> memo;
 public:
   LoxFunction(std::shared_ptr<Function> declaration, std::shared_ptr<Environment> closure, bool isInitializer)
     : declaration{std::move(declaration)}, closure{std::move(closure)}, isInitializer{isInitializer}
@@ -24,7 +37,11 @@ public:
   std::string toString() override;
   int arity() override;
   std::shared_ptr<LoxFunction> bind(std::shared_ptr<LoxInstance> instance);
-  std::any call(Interpreter& interpreter, std::vector<std::any>&& arguments) override;
+  std::any call(Interpreter& interpreter, std::span<std::any> arguments) override;
+private:
+  std::any callMemoized(Interpreter& interpreter, std::span<std::any> arguments);
+  std::any invoke(Interpreter& interpreter, std::span<std::any> arguments);
+  std::any run(Interpreter& interpreter, std::shared_ptr<Environment> environment);
 };
 
 
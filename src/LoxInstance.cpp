@@ -14,6 +14,11 @@ std::any LoxInstance::get(Token& name) {
   throw RuntimeError(name, "Undefined property '" + name.lexeme + "'.");
 }
 
+std::any* LoxInstance::findField(const std::string& name) {
+  auto elem = fields.find(name);
+  return elem != fields.end() ? &elem->second : nullptr;
+}
+
 void LoxInstance::set(Token name, std::any value) {
   fields[name.lexeme] = std::move(value);
 }
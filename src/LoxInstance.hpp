@@ -9,12 +9,17 @@ class LoxClass;
 class Token;
 
 class LoxInstance : public std::enable_shared_from_this<LoxInstance> {
+  friend class AstStats;
+  friend class Interpreter;
+
   std::shared_ptr<LoxClass> klass;
   std::map<std::string, std::any> fields;
 public:
   LoxInstance(std::shared_ptr<LoxClass> klass)
     : klass{std::move(klass)} {}
   std::any get(Token& name);
+  // The field's value, or nullptr if the instance has no such field.
+  std::any* findField(const std::string& name);
   void set(Token name, std::any value);
   std::string toString();
 };
@@ -0,0 +1,210 @@
+#include <algorithm>
+#include "LoxIsolate.hpp"
+#include "Lox.hpp"
+#include "LoxNative.hpp"
+#include "LoxString.hpp"
+#include "LoxList.hpp"
+#include "LoxMap.hpp"
+#include "LoxFloat64Array.hpp"
+#include "Environment.hpp"
+
+static Message copyValue(const std::any& value, std::vector<const void*>& copying) {
+  Message message;
+  if(value.type() == typeid(nullptr)) return message;
+  if(value.type() == typeid(bool)) {
+    message.kind = Message::Kind::BOOL;
+    message.boolean = std::any_cast<bool>(value);
+    return message;
+  }
+  if(value.type() == typeid(double)) {
+    message.kind = Message::Kind::NUMBER;
+    message.number = std::any_cast<double>(value);
+    return message;
+  }
+  if(value.type() == typeid(std::shared_ptr<LoxString>)) {
+    message.kind = Message::Kind::STRING;
+    message.string = std::any_cast<const std::shared_ptr<LoxString>&>(value)->str();
+    return message;
+  }
+  if(value.type() == typeid(std::shared_ptr<LoxFloat64Array>)) {
+    message.kind = Message::Kind::FLOAT64ARRAY;
+    message.numbers = std::any_cast<const std::shared_ptr<LoxFloat64Array>&>(value)->elements;
+    return message;
+  }
+  if(value.type() == typeid(std::shared_ptr<LoxList>)) {
+    LoxList* list = std::any_cast<const std::shared_ptr<LoxList>&>(value).get();
+    if(std::find(copying.begin(), copying.end(), list) != copying.end()) {
+      throw NativeError("Cannot send a value that contains itself.");
+    }
+    copying.push_back(list);
+    message.kind = Message::Kind::LIST;
+    message.items.reserve(list->elements.size());
+    for(const std::any& element : list->elements) message.items.push_back(copyValue(element, copying));
+    copying.pop_back();
+    return message;
+  }
+  if(value.type() == typeid(std::shared_ptr<LoxMap>)) {
+    LoxMap* map = std::any_cast<const std::shared_ptr<LoxMap>&>(value).get();
+    if(std::find(copying.begin(), copying.end(), map) != copying.end()) {
+      throw NativeError("Cannot send a value that contains itself.");
+    }
+    copying.push_back(map);
+    message.kind = Message::Kind::MAP;
+    message.items.reserve(map->size() * 2);
+    for(auto [key, item] : map->items()) {
+      message.items.push_back(copyValue(*key, copying));
+      message.items.push_back(copyValue(*item, copying));
+    }
+    copying.pop_back();
+    return message;
+  }
+  throw NativeError("Only nil, booleans, numbers, strings, lists, maps and Float64Arrays can be sent.");
+}
+
+Message Message::copy(const std::any& value) {
+  std::vector<const void*> copying;
+  return copyValue(value, copying);
+}
+
+std::any Message::rebuild() const {
+  switch(kind) {
+    case Kind::NIL: return nullptr;
+    case Kind::BOOL: return boolean;
+    case Kind::NUMBER: return number;
+    case Kind::STRING: return std::make_shared<LoxString>(string);
+    case Kind::LIST: {
+      std::vector<std::any> elements;
+      elements.reserve(items.size());
+      for(const Message& item : items) elements.push_back(item.rebuild());
+      return std::make_shared<LoxList>(std::move(elements));
+    }
+    case Kind::MAP: {
+      auto map = std::make_shared<LoxMap>();
+      for(size_t i = 0; i + 1 < items.size(); i += 2) map->set(items[i].rebuild(), items[i + 1].rebuild());
+      return map;
+    }
+    case Kind::FLOAT64ARRAY: {
+      auto array = std::make_shared<LoxFloat64Array>(0);
+      array->elements = numbers;
+      return array;
+    }
+  }
+  return nullptr;
+}
+
+void MessageQueue::wake() {
+  signal.fetch_add(1, std::memory_order_release);
+  signal.notify_all();
+}
+
+bool MessageQueue::push(std::unique_ptr<Message> message) {
+  size_t t = tail.load(std::memory_order_relaxed);
+  while(true) {
+    uint32_t seen = signal.load(std::memory_order_acquire);
+    if(closed.load(std::memory_order_acquire)) return false;
+    if(t - head.load(std::memory_order_acquire) < capacity) break;
+    signal.wait(seen, std::memory_order_acquire);
+  }
+  slots[t % capacity] = std::move(message);
+  tail.store(t + 1, std::memory_order_release);
+  wake();
+  return true;
+}
+
+std::unique_ptr<Message> MessageQueue::pop() {
+  size_t h = head.load(std::memory_order_relaxed);
+  while(true) {
+    uint32_t seen = signal.load(std::memory_order_acquire);
+    if(tail.load(std::memory_order_acquire) != h) break;
+    if(closed.load(std::memory_order_acquire)) return nullptr;
+    signal.wait(seen, std::memory_order_acquire);
+  }
+  std::unique_ptr<Message> message = std::move(slots[h % capacity]);
+  head.store(h + 1, std::memory_order_release);
+  wake();
+  return message;
+}
+
+void MessageQueue::close() {
+  closed.store(true, std::memory_order_release);
+  wake();
+}
+
+LoxIsolate::~LoxIsolate() {
+  close();
+}
+
+void LoxIsolate::close() {
+  inbox->close();
+  outbox->close();
+  if(thread.joinable()) thread.join();
+}
+
+std::shared_ptr<LoxIsolate> LoxIsolate::spawn(std::string source) {
+  auto toChild = std::make_shared<MessageQueue>();
+  auto toParent = std::make_shared<MessageQueue>();
+  auto isolate = std::make_shared<LoxIsolate>(toParent, toChild);
+  isolate->thread = std::thread([source = std::move(source), toChild, toParent]() mutable {
+    // The child's `parent` end cannot be relied on to close the queues:
+    // a global function and the globals keep each other alive, so the
+    // session's globals are never destroyed. Close them once the script
+    // is done, however it ends, after its output has been flushed.
+    struct CloseQueues {
+      MessageQueue& toChild;
+      MessageQueue& toParent;
+      ~CloseQueues() {
+        toChild.close();
+        toParent.close();
+      }
+    } closeQueues{*toChild, *toParent};
+    Lox lox;
+    lox.define("parent", std::make_shared<LoxIsolate>(toChild, toParent));
+    lox.run(std::move(source));
+    lox.flush();
+  });
+  return isolate;
+}
+
+bool LoxIsolate::send(const std::any& value) {
+  return outbox->push(std::make_unique<Message>(Message::copy(value)));
+}
+
+std::any LoxIsolate::receive() {
+  std::unique_ptr<Message> message = inbox->pop();
+  if(message == nullptr) return nullptr;
+  return message->rebuild();
+}
+
+static std::shared_ptr<LoxIsolate> asIsolate(std::any& value, const std::string& function) {
+  if(value.type() != typeid(std::shared_ptr<LoxIsolate>)) {
+    throw NativeError("First argument to '" + function + "' must be an isolate.");
+  }
+  return std::any_cast<std::shared_ptr<LoxIsolate>>(value);
+}
+
+void LoxIsolate::defineNatives(Environment& globals) {
+  globals.define("spawn", std::make_shared<LoxNative>("spawn", 1,
+    [](Interpreter& interpreter, std::span<std::any> arguments) -> std::any {
+      if(arguments[0].type() != typeid(std::shared_ptr<LoxString>)) {
+        throw NativeError("Argument to 'spawn' must be a script source string.");
+      }
+      std::shared_ptr<LoxIsolate> isolate = spawn(std::any_cast<std::shared_ptr<LoxString>&>(arguments[0])->str());
+      // Handles that are gone have joined their isolate already.
+      std::erase_if(interpreter.isolates, [](const std::weak_ptr<LoxIsolate>& handle) { return handle.expired(); });
+      interpreter.isolates.push_back(isolate);
+      return isolate;
+    }));
+
+  // Returns false if the other side has finished.
+  globals.define("send", std::make_shared<LoxNative>("send", 2,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      return asIsolate(arguments[0], "send")->send(arguments[1]);
+    }));
+
+  // Waits for the next message; nil once the other side has finished and
+  // every message it sent has been received.
+  globals.define("receive", std::make_shared<LoxNative>("receive", 1,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      return asIsolate(arguments[0], "receive")->receive();
+    }));
+}
@@ -0,0 +1,80 @@
+#ifndef __LOXISOLATE_H
+#define __LOXISOLATE_H
+
+#include <any>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Environment;
+
+// A value copied out of one isolate's heap so it can be rebuilt in
+// another. Only plain data can be sent: nil, booleans, numbers, strings,
+// lists, maps and Float64Arrays. Lists and maps keep their items in
+// `items` (maps as alternating keys and values).
+struct Message {
+  enum class Kind { NIL, BOOL, NUMBER, STRING, LIST, MAP, FLOAT64ARRAY };
+  Kind kind = Kind::NIL;
+  bool boolean = false;
+  double number = 0;
+  std::string string;
+  std::vector<Message> items;
+  std::vector<double> numbers;
+
+  // Throws NativeError for values that cannot be sent or that contain
+  // themselves.
+  static Message copy(const std::any& value);
+  std::any rebuild() const;
+};
+
+// Bounded single-producer single-consumer ring of messages. push and pop
+// only touch the head and tail counters; a thread waits on `signal` only
+// when the ring is full or empty.
+class MessageQueue {
+  static constexpr size_t capacity = 1024;
+  std::unique_ptr<Message> slots[capacity];
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) std::atomic<size_t> tail{0};
+  alignas(64) std::atomic<uint32_t> signal{0};
+  std::atomic<bool> closed{false};
+
+  void wake();
+public:
+  // Blocks while the ring is full. Returns false if the queue was closed.
+  bool push(std::unique_ptr<Message> message);
+  // Blocks while the ring is empty. Returns nullptr once the queue is
+  // closed and drained.
+  std::unique_ptr<Message> pop();
+  void close();
+};
+
+// One end of the pair of queues between a parent and an isolate. The
+// parent's end also owns the isolate's thread: dropping it closes both
+// queues and waits for the isolate to finish.
+class LoxIsolate {
+  std::shared_ptr<MessageQueue> inbox;
+  std::shared_ptr<MessageQueue> outbox;
+  std::thread thread;
+public:
+  LoxIsolate(std::shared_ptr<MessageQueue> inbox, std::shared_ptr<MessageQueue> outbox)
+    : inbox{std::move(inbox)}, outbox{std::move(outbox)} {}
+  ~LoxIsolate();
+  LoxIsolate(LoxIsolate& other) = delete;
+  LoxIsolate& operator=(LoxIsolate& other) = delete;
+
+  // Starts `source` in a new session on its own thread. The script sees
+  // the other end of the returned channel as the global `parent`.
+  static std::shared_ptr<LoxIsolate> spawn(std::string source);
+  // Closes both queues and, on the parent's end, waits for the isolate's
+  // thread to finish.
+  void close();
+  bool send(const std::any& value);
+  std::any receive();
+
+  static void defineNatives(Environment& globals);
+};
+
+#endif
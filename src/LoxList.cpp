@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cmath>
+#include "LoxList.hpp"
+#include "LoxNative.hpp"
+#include "LoxString.hpp"
+#include "Environment.hpp"
+
+static std::shared_ptr<LoxList> asList(std::any& value, const std::string& function) {
+  if(value.type() != typeid(std::shared_ptr<LoxList>)) {
+    throw NativeError("Argument to '" + function + "' must be a list.");
+  }
+  return std::any_cast<std::shared_ptr<LoxList>>(value);
+}
+
+static size_t asPosition(std::any& value, size_t limit, const std::string& function) {
+  if(value.type() != typeid(double)) {
+    throw NativeError("Index passed to '" + function + "' must be a number.");
+  }
+  double position = std::any_cast<double>(value);
+  if(position != std::floor(position)) {
+    throw NativeError("Index passed to '" + function + "' must be an integer.");
+  }
+  if(position < 0 || position > limit) {
+    throw NativeError("Index passed to '" + function + "' is out of bounds.");
+  }
+  return static_cast<size_t>(position);
+}
+
+void LoxList::defineNatives(Environment& globals) {
+  globals.define("List", std::make_shared<LoxNative>("List", 0, LoxNative::pure,
+    [](Interpreter&, std::span<std::any>) -> std::any {
+      return std::make_shared<LoxList>();
+    }));
+
+  globals.define("append", std::make_shared<LoxNative>("append", 2,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      asList(arguments[0], "append")->elements.push_back(std::move(arguments[1]));
+      return nullptr;
+    }));
+
+  globals.define("insert", std::make_shared<LoxNative>("insert", 3,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxList> list = asList(arguments[0], "insert");
+      size_t position = asPosition(arguments[1], list->elements.size(), "insert");
+      list->elements.insert(list->elements.begin() + position, std::move(arguments[2]));
+      return nullptr;
+    }));
+
+  globals.define("slice", std::make_shared<LoxNative>("slice", 3, LoxNative::pure,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxList> list = asList(arguments[0], "slice");
+      size_t start = asPosition(arguments[1], list->elements.size(), "slice");
+      size_t end = asPosition(arguments[2], list->elements.size(), "slice");
+      if(end < start) end = start;
+      return std::make_shared<LoxList>(std::vector<std::any>(list->elements.begin() + start, list->elements.begin() + end));
+    }));
+
+  globals.define("sort", std::make_shared<LoxNative>("sort", 1,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::vector<std::any>& elements = asList(arguments[0], "sort")->elements;
+      bool numbers = std::all_of(elements.begin(), elements.end(), [](const std::any& element) {
+        return element.type() == typeid(double);
+      });
+      bool strings = std::all_of(elements.begin(), elements.end(), [](const std::any& element) {
+        return element.type() == typeid(std::shared_ptr<LoxString>);
+      });
+      if(numbers) {
+        // NaN sorts last so the comparison stays a strict weak ordering.
+        std::sort(elements.begin(), elements.end(), [](const std::any& a, const std::any& b) {
+          double x = std::any_cast<double>(a);
+          double y = std::any_cast<double>(b);
+          return x < y || (std::isnan(y) && !std::isnan(x));
+        });
+      } else if(strings) {
+        std::sort(elements.begin(), elements.end(), [](const std::any& a, const std::any& b) {
+          return std::any_cast<const std::shared_ptr<LoxString>&>(a)->str() < std::any_cast<const std::shared_ptr<LoxString>&>(b)->str();
+        });
+      } else {
+        throw NativeError("Can only sort a list of numbers or a list of strings.");
+      }
+      return nullptr;
+    }));
+}
@@ -0,0 +1,23 @@
+#ifndef __LOXLIST_H
+#define __LOXLIST_H
+
+#include <any>
+#include <memory>
+#include <vector>
+
+class Environment;
+
+// Built-in growable array. Elements live in one contiguous vector and are
+// read and written by index without going through instance fields.
+class LoxList {
+public:
+  std::vector<std::any> elements;
+
+  LoxList() {}
+  LoxList(std::vector<std::any> elements)
+    : elements(std::move(elements)) {}
+
+  static void defineNatives(Environment& globals);
+};
+
+#endif
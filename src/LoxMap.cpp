@@ -0,0 +1,181 @@
+#include <cmath>
+#include <cstring>
+#include "LoxMap.hpp"
+#include "LoxList.hpp"
+#include "LoxNative.hpp"
+#include "LoxString.hpp"
+#include "Environment.hpp"
+
+static uint64_t mix(uint64_t x) {
+  // splitmix64 finalizer
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+uint64_t LoxMap::hashKey(const std::any& key) {
+  uint64_t hash;
+  if(key.type() == typeid(std::shared_ptr<LoxString>)) {
+    hash = mix(std::any_cast<const std::shared_ptr<LoxString>&>(key)->hashCode());
+  } else if(key.type() == typeid(double)) {
+    double number = std::any_cast<double>(key);
+    if(std::isnan(number)) throw NativeError("Map key cannot be NaN.");
+    if(number == 0) number = 0;  // -0 and 0 are the same key
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    hash = mix(bits);
+  } else if(key.type() == typeid(bool)) {
+    hash = mix(std::any_cast<bool>(key) ? 0x7472756500000001ull : 0x66616c7365000002ull);
+  } else {
+    throw NativeError("Map keys must be strings, numbers or booleans.");
+  }
+  // 0 and 1 mark empty and deleted slots.
+  return hash < 2 ? hash + 2 : hash;
+}
+
+bool LoxMap::keysEqual(const std::any& a, const std::any& b) {
+  if(a.type() != b.type()) return false;
+  if(a.type() == typeid(double)) return std::any_cast<double>(a) == std::any_cast<double>(b);
+  if(a.type() == typeid(bool)) return std::any_cast<bool>(a) == std::any_cast<bool>(b);
+  return std::any_cast<const std::shared_ptr<LoxString>&>(a)->equals(*std::any_cast<const std::shared_ptr<LoxString>&>(b));
+}
+
+size_t LoxMap::findSlot(const std::any& key, uint64_t hash) const {
+  size_t mask = hashes.size() - 1;
+  for(size_t index = hash & mask; ; index = (index + 1) & mask) {
+    uint64_t slot = hashes[index];
+    if(slot == empty) return index;
+    if(slot == hash && keysEqual(entries[index].key, key)) return index;
+  }
+}
+
+void LoxMap::rehash(size_t capacity) {
+  std::vector<uint64_t> oldHashes = std::move(hashes);
+  std::vector<Entry> oldEntries = std::move(entries);
+  hashes.assign(capacity, empty);
+  entries.clear();
+  entries.resize(capacity);
+  tombstones = 0;
+  size_t mask = capacity - 1;
+  for(size_t i = 0; i < oldHashes.size(); i++) {
+    if(oldHashes[i] <= tombstone) continue;
+    size_t index = oldHashes[i] & mask;
+    while(hashes[index] != empty) index = (index + 1) & mask;
+    hashes[index] = oldHashes[i];
+    entries[index] = std::move(oldEntries[i]);
+  }
+}
+
+std::any* LoxMap::find(const std::any& key) {
+  uint64_t hash = hashKey(key);
+  if(count == 0) return nullptr;
+  size_t index = findSlot(key, hash);
+  if(hashes[index] == empty) return nullptr;
+  return &entries[index].value;
+}
+
+void LoxMap::set(const std::any& key, std::any value) {
+  uint64_t hash = hashKey(key);
+  if((count + tombstones + 1) * 4 > hashes.size() * 3) {
+    // Grow unless most of the load is tombstones, then just clean up.
+    size_t capacity = std::max(minCapacity, hashes.size());
+    if((count + 1) * 2 > capacity) capacity *= 2;
+    rehash(capacity);
+  }
+  size_t mask = hashes.size() - 1;
+  size_t reusable = hashes.size();
+  for(size_t index = hash & mask; ; index = (index + 1) & mask) {
+    uint64_t slot = hashes[index];
+    if(slot == tombstone) {
+      if(reusable == hashes.size()) reusable = index;
+    } else if(slot == empty) {
+      if(reusable != hashes.size()) {
+        index = reusable;
+        tombstones--;
+      }
+      hashes[index] = hash;
+      entries[index].key = key;
+      entries[index].value = std::move(value);
+      count++;
+      return;
+    } else if(slot == hash && keysEqual(entries[index].key, key)) {
+      entries[index].value = std::move(value);
+      return;
+    }
+  }
+}
+
+bool LoxMap::remove(const std::any& key) {
+  uint64_t hash = hashKey(key);
+  if(count == 0) return false;
+  size_t index = findSlot(key, hash);
+  if(hashes[index] == empty) return false;
+  hashes[index] = tombstone;
+  entries[index] = Entry{};
+  count--;
+  tombstones++;
+  return true;
+}
+
+std::vector<std::any> LoxMap::keys() const {
+  std::vector<std::any> result;
+  result.reserve(count);
+  for(size_t i = 0; i < hashes.size(); i++) {
+    if(hashes[i] > tombstone) result.push_back(entries[i].key);
+  }
+  return result;
+}
+
+std::vector<std::pair<const std::any*, const std::any*>> LoxMap::items() const {
+  std::vector<std::pair<const std::any*, const std::any*>> result;
+  result.reserve(count);
+  for(size_t i = 0; i < hashes.size(); i++) {
+    if(hashes[i] > tombstone) result.emplace_back(&entries[i].key, &entries[i].value);
+  }
+  return result;
+}
+
+static std::shared_ptr<LoxMap> asMap(std::any& value, const std::string& function) {
+  if(value.type() != typeid(std::shared_ptr<LoxMap>)) {
+    throw NativeError("Argument to '" + function + "' must be a map.");
+  }
+  return std::any_cast<std::shared_ptr<LoxMap>>(value);
+}
+
+void LoxMap::defineNatives(Environment& globals) {
+  globals.define("Map", std::make_shared<LoxNative>("Map", 0, LoxNative::pure,
+    [](Interpreter&, std::span<std::any>) -> std::any {
+      return std::make_shared<LoxMap>();
+    }));
+
+  globals.define("get", std::make_shared<LoxNative>("get", 2, LoxNative::pure,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      std::any* value = asMap(arguments[0], "get")->find(arguments[1]);
+      if(value == nullptr) return nullptr;
+      return *value;
+    }));
+
+  globals.define("set", std::make_shared<LoxNative>("set", 3,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      asMap(arguments[0], "set")->set(arguments[1], arguments[2]);
+      return arguments[2];
+    }));
+
+  globals.define("has", std::make_shared<LoxNative>("has", 2, LoxNative::pure,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      return asMap(arguments[0], "has")->find(arguments[1]) != nullptr;
+    }));
+
+  globals.define("delete", std::make_shared<LoxNative>("delete", 2,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      return asMap(arguments[0], "delete")->remove(arguments[1]);
+    }));
+
+  globals.define("keys", std::make_shared<LoxNative>("keys", 1, LoxNative::pure,
+    [](Interpreter&, std::span<std::any> arguments) -> std::any {
+      return std::make_shared<LoxList>(asMap(arguments[0], "keys")->keys());
+    }));
+}
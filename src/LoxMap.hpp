@@ -0,0 +1,57 @@
+#ifndef __LOXMAP_H
+#define __LOXMAP_H
+
+#include <any>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class Environment;
+
+// Built-in hash map keyed by strings, numbers and booleans.
+//
+// Open addressing with linear probing. The full 64-bit hash of every slot
+// is kept in its own array, so a probe sequence scans densely packed
+// hashes and only touches an entry when the hash matches. Deleted slots
+// become tombstones that are reused by inserts and dropped on rehash.
+//
+// Memory: a slot is 40 bytes (8 for the hash, 16 each for the key and
+// value std::any) and the table stays at most 3/4 full, so an entry costs
+// between 53 and 107 bytes. Values too large for std::any's inline
+// storage, such as strings, add an out-of-line copy of their
+// shared_ptr (about 32 bytes).
+class LoxMap {
+  static constexpr uint64_t empty = 0;
+  static constexpr uint64_t tombstone = 1;
+  static constexpr size_t minCapacity = 8;
+
+  struct Entry {
+    std::any key;
+    std::any value;
+  };
+
+  std::vector<uint64_t> hashes;
+  std::vector<Entry> entries;
+  size_t count = 0;
+  size_t tombstones = 0;
+
+  size_t findSlot(const std::any& key, uint64_t hash) const;
+  void rehash(size_t capacity);
+public:
+  LoxMap() {}
+
+  // Throws NativeError for keys that are not strings, numbers or booleans.
+  static uint64_t hashKey(const std::any& key);
+  static bool keysEqual(const std::any& a, const std::any& b);
+
+  std::any* find(const std::any& key);
+  void set(const std::any& key, std::any value);
+  bool remove(const std::any& key);
+  size_t size() const { return count; }
+  std::vector<std::any> keys() const;
+  std::vector<std::pair<const std::any*, const std::any*>> items() const;
+
+  static void defineNatives(Environment& globals);
+};
+
+#endif
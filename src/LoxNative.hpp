@@ -0,0 +1,46 @@
+#ifndef __LOXNATIVE_H
+#define __LOXNATIVE_H
+
+#include <any>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "LoxCallable.hpp"
+
+// Thrown by native functions. The interpreter turns it into a RuntimeError
+// at the call site so the error points at the script line.
+class NativeError : public std::runtime_error {
+public:
+  NativeError(const std::string& message) : std::runtime_error(message) {}
+};
+
+class LoxNative : public LoxCallable {
+public:
+  using Body = std::function<std::any(Interpreter& interpreter, std::span<std::any> arguments)>;
+  // Marks a native that only reads its arguments and has no other
+  // effects, so callbacks that use it can run in parallel.
+  struct Pure {};
+  static constexpr Pure pure{};
+private:
+  std::string name;
+  int argumentCount;
+  Body body;
+  bool pureNative;
+public:
+  LoxNative(std::string name, int arity, Body body)
+    : name{std::move(name)}, argumentCount{arity}, body{std::move(body)}, pureNative{false}
+  {}
+  LoxNative(std::string name, int arity, Pure, Body body)
+    : name{std::move(name)}, argumentCount{arity}, body{std::move(body)}, pureNative{true}
+  {}
+  bool isPure() const { return pureNative; }
+  std::string toString() override { return "<native fn " + name + ">"; }
+  int arity() override { return argumentCount; }
+  std::any call(Interpreter& interpreter, std::span<std::any> arguments) override {
+    return body(interpreter, arguments);
+  }
+};
+
+#endif
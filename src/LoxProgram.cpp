@@ -0,0 +1,45 @@
+#include <stdexcept>
+#include "LoxProgram.hpp"
+#include "Lox.hpp"
+#include "LoxFunction.hpp"
+#include "LoxClass.hpp"
+#include "RuntimeError.hpp"
+
+LoxEntryPoint::LoxEntryPoint(Lox& lox, std::shared_ptr<LoxCallable> callable)
+  : lox{lox}, callable{std::move(callable)} {
+  arity = this->callable->arity();
+}
+
+std::any LoxEntryPoint::call(std::vector<std::any> arguments) {
+  if(arguments.size() != arity) {
+    throw std::runtime_error("Expected " + std::to_string(arity) + " arguments but got " + 
+      std::to_string(arguments.size()) + ".");
+  }
+  hadError = false;
+  std::any result;
+  try {
+    result = callable->call(lox.interpreter, arguments);
+  } catch (RuntimeError& error) {
+    lox.runtimeError(error);
+    hadError = true;
+    return nullptr;
+  }
+  if(result.type() == typeid(std::shared_ptr<LoxString>)) 
+    return std::any_cast<std::shared_ptr<LoxString>&>(result)->str();
+  return result;
+}
+
+bool LoxProgram::run() {
+  return lox.execute(statements);
+}
+
+LoxEntryPoint LoxProgram::function(const std::string& name) {
+  std::any* value = lox.interpreter.globals->find(name);
+  if(value == nullptr)
+    throw std::runtime_error("Undefined function '" + name + "'.");
+  if(value->type() == typeid(std::shared_ptr<LoxFunction>))
+    return LoxEntryPoint(lox, std::any_cast<std::shared_ptr<LoxFunction>>(*value));
+  if(value->type() == typeid(std::shared_ptr<LoxClass>))
+    return LoxEntryPoint(lox, std::any_cast<std::shared_ptr<LoxClass>>(*value));
+  throw std::runtime_error("'" + name + "' is not a function or class.");
+}
@@ -0,0 +1,60 @@
+#ifndef __LOXPROGRAM_H
+#define __LOXPROGRAM_H
+
+#include <any>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LoxString.hpp"
+
+class Lox;
+class LoxCallable;
+struct Stmt;
+
+// A global Lox function looked up from C++. Arguments may be numbers,
+// bools, strings or nullptr (nil); results come back as double, bool,
+// std::string, nullptr or the runtime object itself. A runtime error
+// inside the call is reported to the session and the call returns nil.
+class LoxEntryPoint {
+  Lox& lox;
+  std::shared_ptr<LoxCallable> callable;
+  int arity;
+  bool hadError = false;
+
+  static std::any value(double n) { return n; }
+  static std::any value(int n) { return static_cast<double>(n); }
+  static std::any value(bool b) { return b; }
+  static std::any value(std::nullptr_t) { return nullptr; }
+  static std::any value(const char* s) { return std::make_shared<LoxString>(s); }
+  static std::any value(std::string s) { return std::make_shared<LoxString>(std::move(s)); }
+  static std::any value(std::any v) { return v; }
+public:
+  LoxEntryPoint(Lox& lox, std::shared_ptr<LoxCallable> callable);
+
+  std::any call(std::vector<std::any> arguments);
+  template <class... Args>
+  std::any operator()(Args&&... args) {
+    return call({value(std::forward<Args>(args))...});
+  }
+  // True if the most recent call ended in a runtime error.
+  bool failed() const { return hadError; }
+};
+
+// A script scanned, parsed and resolved once against a session. run()
+// executes its top-level statements; the functions it declares can then
+// be called from C++ any number of times without touching the front end.
+class LoxProgram {
+  friend class Lox;
+
+  Lox& lox;
+  std::vector<std::shared_ptr<Stmt>> statements;
+public:
+  LoxProgram(Lox& lox, std::vector<std::shared_ptr<Stmt>> statements)
+    : lox{lox}, statements{std::move(statements)} {}
+
+  bool run();
+  // Throws std::runtime_error if the global is missing or not callable.
+  LoxEntryPoint function(const std::string& name);
+};
+
+#endif
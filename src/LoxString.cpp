@@ -0,0 +1,90 @@
+#include <mutex>
+#include <vector>
+#include "LoxString.hpp"
+
+static std::mutex flattening;
+
+LoxString::~LoxString() {
+  unlink();
+}
+
+void LoxString::unlink() const {
+  // A string built by repeated appends is a deep left-leaning rope, so
+  // release it iteratively instead of letting the destructors recurse.
+  std::vector<std::shared_ptr<LoxString>> pending;
+  if(left != nullptr) pending.push_back(std::move(left));
+  if(right != nullptr) pending.push_back(std::move(right));
+  while(!pending.empty()) {
+    std::shared_ptr<LoxString> node = std::move(pending.back());
+    pending.pop_back();
+    if(node.use_count() == 1) {
+      // Pairs with the release in the other owners' reference drops.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if(node->left != nullptr) pending.push_back(std::move(node->left));
+      if(node->right != nullptr) pending.push_back(std::move(node->right));
+    }
+  }
+}
+
+std::shared_ptr<LoxString> LoxString::concat(const std::shared_ptr<LoxString>& a, const std::shared_ptr<LoxString>& b) {
+  if(a->length == 0) return b;
+  if(b->length == 0) return a;
+  if(a->length + b->length < minRopeLength) {
+    std::string text;
+    text.reserve(a->length + b->length);
+    text.append(a->str());
+    text.append(b->str());
+    return std::make_shared<LoxString>(std::move(text));
+  }
+  return std::make_shared<LoxString>(a, b);
+}
+
+void LoxString::flatten() const {
+  // Another thread may be flattening this rope or one that shares nodes
+  // with it, so rope structure is only read or changed under the lock.
+  std::lock_guard<std::mutex> lock(flattening);
+  if(isFlat.load(std::memory_order_relaxed)) return;
+  std::string text;
+  text.reserve(length);
+  std::vector<const LoxString*> stack{this};
+  while(!stack.empty()) {
+    const LoxString* node = stack.back();
+    stack.pop_back();
+    if(node->isFlat.load(std::memory_order_relaxed)) {
+      text.append(node->flat);
+    } else {
+      stack.push_back(node->right.get());
+      stack.push_back(node->left.get());
+    }
+  }
+  flat = std::move(text);
+  isFlat.store(true, std::memory_order_release);
+  unlink();
+}
+
+const std::string& LoxString::str() const {
+  if(!isFlat.load(std::memory_order_acquire)) flatten();
+  return flat;
+}
+
+size_t LoxString::hashCode() const {
+  size_t h = hash.load(std::memory_order_relaxed);
+  if(h == 0) {
+    // FNV-1a. Threads that race here compute the same value.
+    h = 14695981039346656037ull;
+    for(unsigned char c : str()) {
+      h ^= c;
+      h *= 1099511628211ull;
+    }
+    if(h == 0) h = 1;
+    hash.store(h, std::memory_order_relaxed);
+  }
+  return h;
+}
+
+bool LoxString::equals(const LoxString& other) const {
+  if(this == &other) return true;
+  if(length != other.length) return false;
+  if(hashCode() != other.hashCode()) return false;
+  return str() == other.str();
+}
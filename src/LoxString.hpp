@@ -0,0 +1,44 @@
+#ifndef __LOXSTRING_H
+#define __LOXSTRING_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+// Immutable runtime string. Values hold a std::shared_ptr<LoxString>, so
+// passing and storing strings only touches the reference count. Long
+// concatenations build a rope node that is flattened the first time its
+// characters are needed; the hash is computed once and cached.
+//
+// Strings may be read from several threads at once (see parallelMap).
+// Flattening is done under a lock shared by all strings and published
+// through `isFlat`; `flat` never changes once it is set. The cached hash
+// is an atomic where 0 means "not computed yet".
+class LoxString {
+  static constexpr size_t minRopeLength = 64;
+  mutable std::string flat;
+  mutable std::shared_ptr<LoxString> left;
+  mutable std::shared_ptr<LoxString> right;
+  mutable std::atomic<bool> isFlat;
+  size_t length;
+  mutable std::atomic<size_t> hash{0};
+
+  void flatten() const;
+  void unlink() const;
+public:
+  explicit LoxString(std::string text)
+    : flat{std::move(text)}, isFlat{true}, length{flat.length()} {}
+  LoxString(std::shared_ptr<LoxString> left, std::shared_ptr<LoxString> right)
+    : left{std::move(left)}, right{std::move(right)}, isFlat{false}, length{this->left->length + this->right->length} {}
+  ~LoxString();
+  LoxString(LoxString& other) = delete;
+  LoxString& operator=(LoxString& other) = delete;
+
+  static std::shared_ptr<LoxString> concat(const std::shared_ptr<LoxString>& a, const std::shared_ptr<LoxString>& b);
+  size_t size() const { return length; }
+  const std::string& str() const;
+  size_t hashCode() const;
+  bool equals(const LoxString& other) const;
+};
+
+#endif
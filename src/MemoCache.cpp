@@ -0,0 +1,90 @@
+#include <cstring>
+#include <memory>
+#include "MemoCache.hpp"
+#include "LoxString.hpp"
+#include "LoxFunction.hpp"
+
+static uint64_t combine(uint64_t seed, uint64_t value) {
+  return (seed ^ value) * 0x100000001b3ull;
+}
+
+bool MemoCache::isValue(const std::any& value) {
+  return value.type() == typeid(double)
+    || value.type() == typeid(std::shared_ptr<LoxString>)
+    || value.type() == typeid(bool)
+    || value.type() == typeid(std::nullptr_t);
+}
+
+bool MemoCache::hash(std::span<const std::any> arguments, uint64_t& hash) {
+  hash = 0xcbf29ce484222325ull;
+  for(const std::any& argument : arguments) {
+    if(argument.type() == typeid(double)) {
+      uint64_t bits;
+      double number = std::any_cast<double>(argument);
+      std::memcpy(&bits, &number, sizeof(bits));
+      hash = combine(hash, bits);
+    } else if(argument.type() == typeid(std::shared_ptr<LoxString>)) {
+      hash = combine(hash, std::any_cast<const std::shared_ptr<LoxString>&>(argument)->hashCode());
+    } else if(argument.type() == typeid(bool)) {
+      hash = combine(hash, std::any_cast<bool>(argument) ? 1 : 2);
+    } else if(argument.type() == typeid(std::nullptr_t)) {
+      hash = combine(hash, 3);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool same(const std::any& a, const std::any& b) {
+  if(a.type() != b.type()) return false;
+  if(a.type() == typeid(double)) {
+    double x = std::any_cast<double>(a);
+    double y = std::any_cast<double>(b);
+    return std::memcmp(&x, &y, sizeof(x)) == 0;
+  }
+  if(a.type() == typeid(bool)) return std::any_cast<bool>(a) == std::any_cast<bool>(b);
+  if(a.type() == typeid(std::nullptr_t)) return true;
+  return std::any_cast<const std::shared_ptr<LoxString>&>(a)->equals(*std::any_cast<const std::shared_ptr<LoxString>&>(b));
+}
+
+bool MemoCache::calleesHold() const {
+  // Stops at the first change: the callees after it may belong to a
+  // closure that is gone.
+  for(const Callee& callee : callees) {
+    auto* function = std::any_cast<std::shared_ptr<LoxFunction>>(callee.cell);
+    if(function == nullptr || function->get() != callee.function) return false;
+  }
+  return true;
+}
+
+const std::any* MemoCache::find(std::span<const std::any> arguments, uint64_t hash) {
+  auto [first, last] = index.equal_range(hash);
+  for(auto candidate = first; candidate != last; ++candidate) {
+    Entry& entry = *candidate->second;
+    bool matches = true;
+    for(size_t i = 0; i < arguments.size() && matches; i++) {
+      matches = same(entry.arguments[i], arguments[i]);
+    }
+    if(!matches) continue;
+    entries.splice(entries.begin(), entries, candidate->second);
+    return &entry.result;
+  }
+  return nullptr;
+}
+
+void MemoCache::insert(std::vector<std::any> arguments, uint64_t hash, std::any result) {
+  if(!isValue(result)) return;
+  if(entries.size() == capacity) {
+    auto [first, last] = index.equal_range(entries.back().hash);
+    for(auto candidate = first; candidate != last; ++candidate) {
+      if(candidate->second == std::prev(entries.end())) {
+        index.erase(candidate);
+        break;
+      }
+    }
+    entries.pop_back();
+  }
+  entries.push_front({hash, std::move(arguments), std::move(result)});
+  index.emplace(hash, entries.begin());
+}
@@ -0,0 +1,56 @@
+#ifndef __MEMOCACHE_H
+#define __MEMOCACHE_H
+
+#include <any>
+#include <cstdint>
+#include <list>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class LoxFunction;
+
+// Results of a memoized function, keyed by its arguments. Only calls
+// whose arguments are all nil, booleans, numbers or strings are cached,
+// and only results of those types are kept, so a hit hands back a value
+// no caller can tell apart from a fresh result. Numbers are compared bit
+// for bit: 0 and -0 are different keys because 1/x tells them apart.
+//
+// The cache holds at most `capacity` results and drops the least
+// recently used one to make room.
+//
+// Results also depend on the functions the memoized one calls, directly
+// or through others. `callees` records where each was read from and what
+// it was when PurityChecker accepted them; the cache may only be used
+// while every one of those variables still holds the same function.
+class MemoCache {
+  struct Entry {
+    uint64_t hash;
+    std::vector<std::any> arguments;
+    std::any result;
+  };
+  // Most recently used first.
+  std::list<Entry> entries;
+  std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+
+public:
+  static constexpr size_t capacity = 4096;
+
+  struct Callee {
+    const std::any* cell;
+    const LoxFunction* function;
+  };
+  // In the order PurityChecker met them: a callee comes before the ones
+  // it calls, whose cells its own closure keeps alive.
+  std::vector<Callee> callees;
+  bool calleesHold() const;
+
+  // Hashes `arguments`, or returns false if one of them cannot be a key.
+  static bool hash(std::span<const std::any> arguments, uint64_t& hash);
+  static bool isValue(const std::any& value);
+
+  const std::any* find(std::span<const std::any> arguments, uint64_t hash);
+  void insert(std::vector<std::any> arguments, uint64_t hash, std::any result);
+};
+
+#endif
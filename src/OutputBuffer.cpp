@@ -0,0 +1,60 @@
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include "OutputBuffer.hpp"
+
+void OutputBuffer::write(const char* data, size_t length) {
+  if(size + length > capacity) {
+    flush();
+    if(length > capacity) {
+      out.write(data, length);
+      return;
+    }
+  }
+  std::memcpy(buffer.get() + size, data, length);
+  size += length;
+}
+
+void OutputBuffer::write(char c) {
+  if(size == capacity) flush();
+  buffer[size++] = c;
+}
+
+void OutputBuffer::writeNumber(double value) {
+  if(capacity - size < maxNumberLength) flush();
+  char* first = buffer.get() + size;
+  size = formatNumber(first, first + maxNumberLength, value) - buffer.get();
+}
+
+void OutputBuffer::newline() {
+  write('\n');
+  if(lineBuffered) flush();
+}
+
+void OutputBuffer::flush() {
+  if(size > 0) {
+    out.write(buffer.get(), size);
+    size = 0;
+  }
+  out.flush();
+}
+
+char* OutputBuffer::formatNumber(char* first, char* last, double value) {
+  // Most numbers scripts print are integral. Below 2^53 they convert to
+  // int64_t exactly, and formatting the integer is about twice as fast as
+  // finding the shortest digits of the double. Zero goes the long way so
+  // that -0 keeps its sign.
+  constexpr double exactIntegers = 9007199254740992.0;
+  if(value > -exactIntegers && value < exactIntegers && value != 0) {
+    int64_t integer = static_cast<int64_t>(value);
+    if(static_cast<double>(integer) == value) return std::to_chars(first, last, integer).ptr;
+  }
+  // Shortest round-trip digits. Plain notation is used in the same range
+  // as JavaScript so that e.g. 500000 is not printed as 5e+05; integral
+  // values come out without a fractional part.
+  double magnitude = value < 0 ? -value : value;
+  if(magnitude == 0 || (magnitude >= 1e-6 && magnitude < 1e21)) {
+    return std::to_chars(first, last, value, std::chars_format::fixed).ptr;
+  }
+  return std::to_chars(first, last, value).ptr;
+}
@@ -0,0 +1,41 @@
+#ifndef __OUTPUTBUFFER_HPP
+#define __OUTPUTBUFFER_HPP
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+// Collects script output in a large user-space buffer and hands it to the
+// underlying stream in big writes. It must be flushed before anything else
+// is written to the terminal (errors, REPL prompts) and on exit. In line
+// buffered mode it is also flushed after every newline.
+class OutputBuffer {
+  static constexpr size_t capacity = 1 << 16;
+  std::ostream& out;
+  std::unique_ptr<char[]> buffer;
+  size_t size;
+  bool lineBuffered;
+public:
+  OutputBuffer(std::ostream& out)
+    : out{out}, buffer{new char[capacity]}, size{0}, lineBuffered{false} {}
+  ~OutputBuffer() { flush(); }
+  OutputBuffer(OutputBuffer& other) = delete;
+  OutputBuffer& operator=(OutputBuffer& other) = delete;
+
+  void setLineBuffered(bool enabled) { lineBuffered = enabled; }
+  std::ostream& stream() { return out; }
+  void write(const char* data, size_t length);
+  void write(std::string_view text) { write(text.data(), text.length()); }
+  void write(char c);
+  void writeNumber(double value);
+  void newline();
+  void flush();
+
+  // Writes the shortest representation of value that reads back to the
+  // same double, without a trailing ".0" for integral values. Returns the
+  // end of the written characters; [first, last) must hold at least
+  // maxNumberLength characters.
+  static constexpr size_t maxNumberLength = 48;
+  static char* formatNumber(char* first, char* last, double value);
+};
+
+#endif
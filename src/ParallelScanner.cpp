@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "ParallelScanner.hpp"
+#include "Lox.hpp"
+
+ParallelScanner::ParallelScanner(Lox& lox, std::string content)
+  : lox(lox), content(std::move(content)), threads(std::thread::hardware_concurrency()) {
+  if(threads == 0) threads = 1;
+}
+
+std::vector<ParallelScanner::Chunk> ParallelScanner::split() {
+  size_t count = std::min<size_t>(threads, content.length() / minChunkSize);
+  std::vector<Chunk> chunks;
+  size_t begin = 0;
+  for(size_t i = 1; i < count && begin < content.length(); i++) {
+    size_t target = std::max(begin, content.length() / count * i);
+    // Cut right after a newline so that no token other than a string can
+    // straddle the boundary.
+    const void* newline = std::memchr(content.data() + target, '\n', content.length() - target);
+    if(newline == nullptr) break;
+    size_t end = static_cast<const char*>(newline) - content.data() + 1;
+    chunks.push_back({begin, end, 1});
+    begin = end;
+  }
+  chunks.push_back({begin, content.length(), 1});
+  return chunks;
+}
+
+std::unique_ptr<Scanner> ParallelScanner::scanChunk(size_t begin, size_t end, int line) {
+  auto scanner = std::make_unique<Scanner>(lox, content.substr(begin, end - begin), line);
+  scanner->chunkMode = true;
+  scanner->scanTokens();
+  return scanner;
+}
+
+std::vector<Token>& ParallelScanner::scanTokens() {
+  std::vector<Chunk> chunks = split();
+  if(chunks.size() == 1) {
+    Scanner scanner = Scanner(lox, std::move(content));
+    tokens = std::move(scanner.scanTokens());
+    return tokens;
+  }
+
+  // First pass: count newlines so every chunk knows its starting line.
+  std::vector<int> newlines(chunks.size());
+  std::vector<std::thread> workers;
+  for(size_t i = 0; i < chunks.size(); i++) {
+    workers.emplace_back([this, &chunks, &newlines, i] {
+      newlines[i] = std::count(content.begin() + chunks[i].begin, content.begin() + chunks[i].end, '\n');
+    });
+  }
+  for(std::thread& worker : workers) worker.join();
+  workers.clear();
+  for(size_t i = 1; i < chunks.size(); i++) {
+    chunks[i].line = chunks[i - 1].line + newlines[i - 1];
+  }
+
+  // Second pass: scan every chunk assuming it starts outside a string.
+  std::vector<std::unique_ptr<Scanner>> scanners(chunks.size());
+  for(size_t i = 0; i < chunks.size(); i++) {
+    workers.emplace_back([this, &chunks, &scanners, i] {
+      scanners[i] = scanChunk(chunks[i].begin, chunks[i].end, chunks[i].line);
+    });
+  }
+  for(std::thread& worker : workers) worker.join();
+
+  // Fix up the boundaries in order and merge the token streams.
+  size_t total = 0;
+  for(auto& scanner : scanners) total += scanner->tokens.size();
+  tokens.reserve(total + 1);
+  for(size_t i = 0; i < scanners.size(); i++) {
+    Scanner& scanner = *scanners[i];
+    if(scanner.endsInString && i + 1 < scanners.size()) {
+      // The string continues into the next chunk, so that chunk was scanned
+      // from the wrong state. Drop the premature error and rescan it from the
+      // opening quote.
+      scanner.errors.pop_back();
+      size_t begin = chunks[i].begin + scanner.stringStart;
+      Chunk& next = chunks[i + 1];
+      if(std::memchr(content.data() + next.begin, '"', next.end - next.begin) == nullptr) {
+        // No closing quote in sight: the whole chunk belongs to the string,
+        // so carry it forward without rescanning.
+        auto carried = std::make_unique<Scanner>(lox, "", scanner.stringLine);
+        carried->endsInString = true;
+        carried->stringLine = scanner.stringLine;
+        carried->line = next.line + newlines[i + 1];
+        carried->errors.emplace_back(carried->line, "Unterminated string.");
+        scanners[i + 1] = std::move(carried);
+      } else {
+        scanners[i + 1] = scanChunk(begin, next.end, scanner.stringLine);
+      }
+      next.begin = begin;
+    }
+    for(auto& [line, message] : scanner.errors) {
+      lox.error(line, message);
+    }
+    for(Token& token : scanner.tokens) {
+      tokens.push_back(std::move(token));
+    }
+    scanner.tokens.clear();
+  }
+  tokens.emplace_back(TokenType::END_OF_FILE, "", nullptr, scanners.back()->line);
+  return tokens;
+}
@@ -0,0 +1,38 @@
+#ifndef __PARALLEL_SCANNER_HPP
+#define __PARALLEL_SCANNER_HPP
+#include <memory>
+#include <string>
+#include <vector>
+#include "Scanner.hpp"
+
+// Scans large sources by splitting them into line-aligned chunks that are
+// scanned speculatively on worker threads. A chunk boundary can only fall
+// inside a string literal (comments end at the newline the chunk starts
+// after), so any chunk that follows one ending in an unterminated string is
+// rescanned from the start of that string before the token streams are
+// merged. The result is identical to the sequential Scanner.
+class ParallelScanner {
+  static constexpr size_t minChunkSize = 1 << 20;
+  Lox& lox;
+  std::string content;
+  unsigned threads;
+
+  struct Chunk {
+    size_t begin;
+    size_t end;
+    int line;
+  };
+
+public:
+  std::vector<Token> tokens;
+  ParallelScanner() = delete;
+  ParallelScanner(Lox& lox, std::string content);
+  ParallelScanner(Lox& lox, std::string content, unsigned threads)
+    : lox(lox), content(std::move(content)), threads(threads) {}
+  std::vector<Token>& scanTokens();
+private:
+  std::vector<Chunk> split();
+  std::unique_ptr<Scanner> scanChunk(size_t begin, size_t end, int line);
+};
+
+#endif
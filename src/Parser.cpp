@@ -3,6 +3,7 @@
 #include "TokenType.hpp"
 #include "Token.hpp"
 #include "Expr.hpp"
+#include "LoxString.hpp"
 
 std::shared_ptr<Expr> Parser::expression() {
   return assignment();
@@ -15,9 +16,13 @@ std::shared_ptr<Expr> Parser::assignment() {
     std::shared_ptr<Expr> value = assignment();
     if(Variable* e = dynamic_cast<Variable*>(expr.get())) {
       const Token& name = e->name;
-      return std::make_shared<Assign>(std::move(name), value);
+      auto assign = std::make_shared<Assign>(std::move(name), value);
+      resolveLocal(assign->depth, assign->name);
+      return assign;
     } else if(Get* e = dynamic_cast<Get*>(expr.get())) {
       return std::make_shared<Set>(e->object, e->name, value);
+    } else if(Index* e = dynamic_cast<Index*>(expr.get())) {
+      return std::make_shared<SetIndex>(e->object, e->bracket, e->index, value);
     }
     error(std::move(equals), "Invalid assignment target.");
   }
@@ -101,6 +106,11 @@ std::shared_ptr<Expr> Parser::call() {
     } else if (match({TokenType::DOT})) {
       Token name = consume(TokenType::IDENTIFIER, "Expect property name after '.'.");
       expr = std::make_shared<Get>(expr, std::move(name));
+    } else if (match({TokenType::LEFT_BRACKET})) {
+      Token bracket = previous();
+      std::shared_ptr<Expr> index = expression();
+      consume(TokenType::RIGHT_BRACKET, "Expect ']' after index.");
+      expr = std::make_shared<Index>(expr, std::move(bracket), std::move(index));
     } else {
       break;
     }
@@ -127,21 +137,55 @@ std::shared_ptr<Expr> Parser::primary() {
   if (match({TokenType::TRUE})) return std::make_shared<Literal>(true);
   if (match({TokenType::NIL})) return std::make_shared<Literal>(nullptr);
 
-  if (match({TokenType::NUMBER, TokenType::STRING})) {
+  if (match({TokenType::NUMBER})) {
     return std::make_shared<Literal>(previous().literal);
   }
 
+  if (match({TokenType::STRING})) {
+    // Built once here so evaluating the literal only shares the string.
+    auto value = std::make_shared<LoxString>(std::any_cast<std::string>(previous().literal));
+    return std::make_shared<Literal>(std::move(value));
+  }
+
   if(match({TokenType::SUPER})) {
     Token keyword = previous();
     consume(TokenType::DOT, "Expect '.' after 'super'.");
     Token method = consume(TokenType::IDENTIFIER, "Expect superclass method name.");
-    return std::make_shared<Super>(keyword, method);
+    auto expr = std::make_shared<Super>(keyword, method);
+    if(interpreter != nullptr) {
+      if(currentClass == ClassType::NONE) {
+        lox.error(expr->keyword, "Cannot use 'super' outside of a class.");
+      } else if(currentClass != ClassType::SUBCLASS) {
+        lox.error(expr->keyword, "Cannot use 'super' in a class with no superclass.");
+      }
+    }
+    resolveLocal(expr->depth, expr->keyword);
+    return expr;
   }
 
-  if(match({TokenType::THIS})) return std::make_shared<This>(previous());
+  if(match({TokenType::THIS})) {
+    auto expr = std::make_shared<This>(previous());
+    if(interpreter != nullptr && currentClass == ClassType::NONE) {
+      lox.error(expr->keyword, "Can't use 'this' outside of a class.");
+      return expr;
+    }
+    resolveLocal(expr->depth, expr->keyword);
+    return expr;
+  }
 
   if(match({TokenType::IDENTIFIER})) {
-    return std::make_shared<Variable>(previous());
+    auto expr = std::make_shared<Variable>(previous());
+    // An assignment target is resolved once the Assign node exists.
+    if(check(TokenType::EQUAL)) return expr;
+    if(interpreter != nullptr && !scopes.empty()) {
+      auto& scope = scopes.back();
+      auto elem = scope.find(expr->name.lexeme);
+      if(elem != scope.end() && elem->second == false) {
+        lox.error(expr->name, "Cannot read local variable in its own initializer.");
+      }
+    }
+    resolveLocal(expr->depth, expr->name);
+    return expr;
   }
 
   if (match({TokenType::LEFT_PAREN})) {
@@ -150,6 +194,18 @@ std::shared_ptr<Expr> Parser::primary() {
     return std::make_shared<Grouping>(std::move(expr));
   }
 
+  if (match({TokenType::LEFT_BRACKET})) {
+    Token bracket = previous();
+    std::vector<std::shared_ptr<Expr>> elements;
+    if (!check(TokenType::RIGHT_BRACKET)) {
+      do {
+        elements.push_back(expression());
+      } while (match({TokenType::COMMA}));
+    }
+    consume(TokenType::RIGHT_BRACKET, "Expect ']' after list elements.");
+    return std::make_shared<ListLiteral>(std::move(bracket), std::move(elements));
+  }
+
   throw error(peek(), "Expect expression.");
 }
 
@@ -159,14 +215,25 @@ std::shared_ptr<Stmt> Parser::statement() {
   if(match({TokenType::PRINT})) return printStatement();
   if(match({TokenType::RETURN})) return returnStatement();
   if(match({TokenType::WHILE})) return whileStatement();
-  if(match({TokenType::LEFT_BRACE})) return std::make_shared<Block>(block());
+  if(match({TokenType::LEFT_BRACE})) {
+    beginScope();
+    std::vector<std::shared_ptr<Stmt>> statements = block();
+    endScope();
+    return std::make_shared<Block>(std::move(statements));
+  }
   return expressionStatement();
 }
 
 std::shared_ptr<Stmt> Parser::returnStatement() {
   Token keyword = previous();
+  if(interpreter != nullptr && currentFunction == FunctionType::NONE) {
+    lox.error(keyword, "Cannot return from top-level code.");
+  }
   std::shared_ptr<Expr> value = nullptr;
   if(!check(TokenType::SEMICOLON)) {
+    if(interpreter != nullptr && currentFunction == FunctionType::INITIALIZER) {
+      lox.error(keyword, "Cannot return a value from an initializer.");
+    }
     value = expression();
   }
   consume(TokenType::SEMICOLON, "Expect ';' after return value.");
@@ -211,12 +278,15 @@ std::shared_ptr<Stmt> Parser::whileStatement() {
 
 std::shared_ptr<Stmt> Parser::forStatement() {
   consume(TokenType::LEFT_PAREN, "Expect '(' after 'for'.");
+  // The initializer gets a scope for the whole loop; see For.
   std::shared_ptr<Stmt> initializer;
   if(match({TokenType::SEMICOLON})) {
     initializer = nullptr;
   } else if(match({TokenType::VAR})) {
+    beginScope();
     initializer = varDeclaration();
   } else {
+    beginScope();
     initializer = expressionStatement();
   }
   std::shared_ptr<Expr> condition = nullptr;
@@ -229,31 +299,36 @@ std::shared_ptr<Stmt> Parser::forStatement() {
     increment = expression();
   }
   consume(TokenType::RIGHT_PAREN, "Expect ')' after for clauses.");
+  int enclosingFunctions = functionCount;
   std::shared_ptr<Stmt> body = statement();
-  if(increment != nullptr) {
-    body = std::make_shared<Block>(std::vector<std::shared_ptr<Stmt>>{
-      body,
-      std::make_shared<Expression>(std::move(increment))
-    });
-  }
+  bool reuseBodyScope = functionCount == enclosingFunctions;
+  if(initializer != nullptr) endScope();
   if(condition == nullptr) condition = std::make_shared<Literal>(true);
-  body = std::make_shared<While>(condition, body);
-  if(initializer != nullptr) {
-    body = std::make_shared<Block>(std::vector<std::shared_ptr<Stmt>>{
-      initializer,
-      body
-    });
-  }
-  return body;
+  return std::make_shared<For>(std::move(initializer), std::move(condition), std::move(increment), std::move(body), reuseBodyScope);
 }
 
 std::shared_ptr<Stmt> Parser::declaration() {
+  size_t depth = scopes.size();
+  FunctionType enclosingFunction = currentFunction;
+  ClassType enclosingClass = currentClass;
   try {
     if(match({TokenType::CLASS})) return classDeclaration();
     if(match({TokenType::FUN})) return function("function");
+    // `pure` is only a keyword in front of `fun`, so it stays usable as a
+    // name.
+    if(check(TokenType::IDENTIFIER) && peek().lexeme == "pure" && checkNext(TokenType::FUN)) {
+      advance();
+      advance();
+      std::shared_ptr<Function> declaration = function("function");
+      declaration->pure = true;
+      return declaration;
+    }
     if(match({TokenType::VAR})) return varDeclaration();
     return statement();
   } catch(ParseError& error) {
+    scopes.resize(depth);
+    currentFunction = enclosingFunction;
+    currentClass = enclosingClass;
     syncronize();
     return nullptr;
   }
@@ -261,23 +336,53 @@ std::shared_ptr<Stmt> Parser::declaration() {
 
 std::shared_ptr<Stmt> Parser::classDeclaration() {
   Token name = consume(TokenType::IDENTIFIER, "Expect class name.");
+  ClassType enclosingClass = currentClass;
+  currentClass = ClassType::CLASS;
+  declare(name);
+  define(name);
+
   std::shared_ptr<Variable> superclass = nullptr;
   if(match({TokenType::LESS})) {
     consume(TokenType::IDENTIFIER, "Expect superclass name.");
     superclass = std::make_shared<Variable>(previous());
+    if(interpreter != nullptr && name.lexeme == superclass->name.lexeme) {
+      lox.error(superclass->name, "A class cannot inherit from itself.");
+    }
+    currentClass = ClassType::SUBCLASS;
+    resolveLocal(superclass->depth, superclass->name);
+    beginScope();
+    if(interpreter != nullptr) scopes.back()["super"] = true;
   }
 
+  beginScope();
+  if(interpreter != nullptr) scopes.back()["this"] = true;
+
   consume(TokenType::LEFT_BRACE, "Expect '{' before class body.");
   std::vector<std::shared_ptr<Function>> methods;
   while(!check(TokenType::RIGHT_BRACE) && !isAtEnd()) {
     methods.push_back(function("method"));
   }
   consume(TokenType::RIGHT_BRACE, "Expect '}' after class body.");
+  endScope();
+  if(superclass != nullptr) endScope();
+  currentClass = enclosingClass;
   return std::make_shared<Class>(std::move(name), superclass, std::move(methods));
 }
 
 std::shared_ptr<Function> Parser::function(std::string kind) {
   Token name = consume(TokenType::IDENTIFIER, "Expect " + kind + " name.");
+  functionCount++;
+  FunctionType type = FunctionType::FUNCTION;
+  if(kind == "method") {
+    type = name.lexeme == "init" ? FunctionType::INITIALIZER : FunctionType::METHOD;
+  } else {
+    declare(name);
+    define(name);
+  }
+  FunctionType enclosingFunction = currentFunction;
+  currentFunction = type;
+  beginScope();
+
   consume(TokenType::LEFT_PAREN, "Expect '(' after " + kind + " name.");
   std::vector<Token> params;
   if (!check(TokenType::RIGHT_PAREN)) {
@@ -286,20 +391,29 @@ std::shared_ptr<Function> Parser::function(std::string kind) {
         error(peek(), "Cannot have more than 255 parameters.");
       }
       params.push_back(consume(TokenType::IDENTIFIER, "Expect parameter name."));
+      declare(params.back());
+      define(params.back());
     } while (match({TokenType::COMMA}));
   }
   consume(TokenType::RIGHT_PAREN, "Expect ')' after parameters.");
   consume(TokenType::LEFT_BRACE, "Expect '{' before " + kind + " body.");
+  int enclosingFunctions = functionCount;
   std::vector<std::shared_ptr<Stmt>> body = block();
-  return std::make_shared<Function>(std::move(name), std::move(params), std::move(body));
+  endScope();
+  currentFunction = enclosingFunction;
+  auto declaration = std::make_shared<Function>(std::move(name), std::move(params), std::move(body));
+  declaration->declaresClosures = functionCount != enclosingFunctions;
+  return declaration;
 }
 
 std::shared_ptr<Stmt> Parser::varDeclaration() {
   Token name = consume(TokenType::IDENTIFIER, "Expect variable name.");
+  declare(name);
   std::shared_ptr<Expr> initializer = nullptr;
   if(match({TokenType::EQUAL})) {
     initializer = expression();
   }
+  define(name);
   consume(TokenType::SEMICOLON, "Expect ';' after variable declaration.");
   return std::make_shared<Var>(name, std::move(initializer));
 }
@@ -329,6 +443,11 @@ bool Parser::check(TokenType type) {
   return peek().type == type;
 }
 
+bool Parser::checkNext(TokenType type) {
+  if (isAtEnd()) return false;
+  return tokens.at(current + 1).type == type;
+}
+
 Token Parser::advance() {
   if (!isAtEnd()) current++;
   return previous();
@@ -348,7 +467,7 @@ Token Parser::consume(TokenType type, std::string message) {
 }
 
 ParseError Parser::error(Token token, const std::string& message) {
-  Lox::error(token, message);
+  lox.error(token, message);
   return ParseError(message);
 }
 
@@ -371,6 +490,40 @@ void Parser::syncronize() {
   }
 }
 
+void Parser::beginScope() {
+  if(interpreter == nullptr) return;
+  scopes.push_back(std::map<std::string, bool>());
+}
+
+void Parser::endScope() {
+  if(interpreter == nullptr) return;
+  scopes.pop_back();
+}
+
+void Parser::declare(const Token& name) {
+  if(scopes.empty()) return;
+  std::map<std::string, bool>& scope = scopes.back();
+  if(scope.find(name.lexeme) != scope.end()) {
+    lox.error(name, "Variable with this name already declared in this scope.");
+  }
+  scope[name.lexeme] = false;
+}
+
+void Parser::define(const Token& name) {
+  if(scopes.empty()) return;
+  scopes.back()[name.lexeme] = true;
+}
+
+void Parser::resolveLocal(int& depth, const Token& name) {
+  if(interpreter == nullptr) return;
+  for(int i = scopes.size() - 1; i >= 0; i--) {
+    if(scopes.at(i).find(name.lexeme) != scopes.at(i).end()) {
+      depth = scopes.size() - 1 - i;
+      return;
+    }
+  }
+}
+
 std::vector<std::shared_ptr<Stmt>> Parser::parse() {
   std::vector<std::shared_ptr<Stmt>> statements;
   while (!isAtEnd()) {
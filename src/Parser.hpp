@@ -1,10 +1,13 @@
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <map>
 #include "TokenType.hpp"
 
 struct Token;
 struct Expr;
+class Interpreter;
+class Lox;
 
 class ParseError : public std::runtime_error {
 public:
@@ -13,8 +16,34 @@ public:
 };
 
 class Parser {
+  Lox& lox;
   std::vector<Token> tokens;
   int current;
+
+  // Variable resolution is done while the tree is built, mirroring the
+  // checks of the standalone Resolver. It is skipped when no interpreter is
+  // given so tooling can still run the Resolver over a plain parse.
+  Interpreter* interpreter;
+  std::vector<std::map<std::string, bool>> scopes;
+
+  enum class FunctionType {
+    NONE,
+    FUNCTION,
+    METHOD,
+    INITIALIZER
+  };
+
+  enum class ClassType {
+    NONE,
+    CLASS,
+    SUBCLASS
+  };
+
+  FunctionType currentFunction = FunctionType::NONE;
+  ClassType currentClass = ClassType::NONE;
+  // Functions and methods parsed so far. A for loop compares it before and
+  // after its body to learn whether closures can capture the body's scope.
+  int functionCount = 0;
 private:
   ParseError error(Token token, const std::string& message);
   // Expression parsing
@@ -46,14 +75,24 @@ private:
   std::vector<std::shared_ptr<Stmt>> block();
   bool match(std::vector<TokenType> types);
   bool check(TokenType type);
+  bool checkNext(TokenType type);
   bool isAtEnd();
   Token advance();
   Token previous();
   Token peek();
   Token consume(TokenType type, std::string message);
   void syncronize();
+
+  // Scope tracking
+  void beginScope();
+  void endScope();
+  void declare(const Token& name);
+  void define(const Token& name);
+  void resolveLocal(int& depth, const Token& name);
 public:
-  Parser(std::vector<Token>& tokens) 
-    : tokens{std::move(tokens)}, current{0} {}
+  Parser(Lox& lox, std::vector<Token>& tokens) 
+    : lox{lox}, tokens{std::move(tokens)}, current{0}, interpreter{nullptr} {}
+  Parser(Lox& lox, std::vector<Token>& tokens, Interpreter& interpreter)
+    : lox{lox}, tokens{std::move(tokens)}, current{0}, interpreter{&interpreter} {}
   std::vector<std::shared_ptr<Stmt>> parse();
 };
\ No newline at end of file
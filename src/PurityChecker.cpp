@@ -0,0 +1,214 @@
+#include "PurityChecker.hpp"
+#include "LoxFunction.hpp"
+#include "LoxNative.hpp"
+#include "Environment.hpp"
+
+bool PurityChecker::isPure(const LoxFunction& callee) {
+  if(checked.count(&callee)) return true;
+  checked.insert(&callee);
+
+  const LoxFunction* enclosingFunction = function;
+  int enclosingDepth = depth;
+  function = &callee;
+  depth = 0;
+  check(callee.declaration->body);
+  function = enclosingFunction;
+  depth = enclosingDepth;
+
+  if(!pure) checked.erase(&callee);
+  return pure;
+}
+
+void PurityChecker::check(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  for(const std::shared_ptr<Stmt>& stmt : statements) {
+    if(!pure) return;
+    check(stmt);
+  }
+}
+
+void PurityChecker::check(const std::shared_ptr<Stmt>& stmt) {
+  stmt->accept(*this);
+}
+
+void PurityChecker::check(const std::shared_ptr<Expr>& expr) {
+  if(pure) expr->accept(*this);
+}
+
+bool PurityChecker::isPureCallee(const std::shared_ptr<Variable>& callee) {
+  int distance = callee->depth;
+  // A local may hold any function by the time it is called.
+  if(distance >= 0 && distance <= depth) return false;
+
+  std::any* cell;
+  if(distance < 0) {
+    cell = interpreter.globals->find(callee->name.lexeme);
+  } else {
+    cell = function->closure->ancestor(distance - depth - 1)->find(callee->name.lexeme);
+  }
+  if(cell == nullptr) return false;
+
+  if(auto* native = std::any_cast<std::shared_ptr<LoxNative>>(cell)) {
+    return !memoizing && (*native)->isPure();
+  }
+  if(auto* loxFunction = std::any_cast<std::shared_ptr<LoxFunction>>(cell)) {
+    // Recorded before the callee's own callees (see MemoCache::callees).
+    callees.push_back({cell, loxFunction->get()});
+    return isPure(**loxFunction);
+  }
+  return false;
+}
+
+std::any PurityChecker::visitBlockStmt(Block& stmt) {
+  depth++;
+  check(stmt.statements);
+  depth--;
+  return {};
+}
+
+std::any PurityChecker::visitExpressionStmt(Expression& stmt) {
+  check(stmt.expression);
+  return {};
+}
+
+std::any PurityChecker::visitFunctionStmt(Function& stmt) {
+  // A nested function runs with this one's environments between it and
+  // the closure, so its body is checked one level deeper.
+  depth++;
+  check(stmt.body);
+  depth--;
+  return {};
+}
+
+std::any PurityChecker::visitIfStmt(If& stmt) {
+  check(stmt.condition);
+  if(pure) check(stmt.thenBranch);
+  if(pure && stmt.elseBranch != nullptr) check(stmt.elseBranch);
+  return {};
+}
+
+std::any PurityChecker::visitPrintStmt(Print& stmt) {
+  pure = false;
+  return {};
+}
+
+std::any PurityChecker::visitClassStmt(Class& stmt) {
+  pure = false;
+  return {};
+}
+
+std::any PurityChecker::visitReturnStmt(Return& stmt) {
+  if(stmt.value != nullptr) check(stmt.value);
+  return {};
+}
+
+std::any PurityChecker::visitVarStmt(Var& stmt) {
+  if(stmt.initializer != nullptr) check(stmt.initializer);
+  return {};
+}
+
+std::any PurityChecker::visitWhileStmt(While& stmt) {
+  check(stmt.condition);
+  if(pure) check(stmt.body);
+  return {};
+}
+
+std::any PurityChecker::visitForStmt(For& stmt) {
+  // The initializer's scope is one more environment, like a block's.
+  if(stmt.initializer != nullptr) {
+    depth++;
+    check(stmt.initializer);
+  }
+  if(pure) check(stmt.condition);
+  if(pure) check(stmt.body);
+  if(pure && stmt.increment != nullptr) check(stmt.increment);
+  if(stmt.initializer != nullptr) depth--;
+  return {};
+}
+
+std::any PurityChecker::visitAssignExpr(Assign& expr) {
+  int distance = expr.depth;
+  if(distance < 0 || distance > depth) {
+    pure = false;
+    return {};
+  }
+  check(expr.value);
+  return {};
+}
+
+std::any PurityChecker::visitBinaryExpr(Binary& expr) {
+  check(expr.left);
+  check(expr.right);
+  return {};
+}
+
+std::any PurityChecker::visitCallExpr(Call& expr) {
+  auto callee = std::dynamic_pointer_cast<Variable>(expr.callee);
+  if(callee == nullptr || !isPureCallee(callee)) {
+    pure = false;
+    return {};
+  }
+  for(const std::shared_ptr<Expr>& argument : expr.arguments) check(argument);
+  return {};
+}
+
+std::any PurityChecker::visitGroupingExpr(Grouping& expr) {
+  check(expr.expression);
+  return {};
+}
+
+std::any PurityChecker::visitLiteralExpr(Literal& expr) {
+  return {};
+}
+
+std::any PurityChecker::visitLogicalExpr(Logical& expr) {
+  check(expr.left);
+  check(expr.right);
+  return {};
+}
+
+std::any PurityChecker::visitUnaryExpr(Unary& expr) {
+  check(expr.right);
+  return {};
+}
+
+std::any PurityChecker::visitGetExpr(Get& expr) {
+  check(expr.object);
+  return {};
+}
+
+std::any PurityChecker::visitSetExpr(Set& expr) {
+  pure = false;
+  return {};
+}
+
+std::any PurityChecker::visitThisExpr(This& expr) {
+  if(memoizing) pure = false;
+  return {};
+}
+
+std::any PurityChecker::visitSuperExpr(Super& expr) {
+  if(memoizing) pure = false;
+  return {};
+}
+
+std::any PurityChecker::visitVariableExpr(Variable& expr) {
+  // Anything outside the function may change between calls.
+  if(memoizing && (expr.depth < 0 || expr.depth > depth)) pure = false;
+  return {};
+}
+
+std::any PurityChecker::visitIndexExpr(Index& expr) {
+  check(expr.object);
+  check(expr.index);
+  return {};
+}
+
+std::any PurityChecker::visitSetIndexExpr(SetIndex& expr) {
+  pure = false;
+  return {};
+}
+
+std::any PurityChecker::visitListLiteralExpr(ListLiteral& expr) {
+  for(const std::shared_ptr<Expr>& element : expr.elements) check(element);
+  return {};
+}
@@ -0,0 +1,78 @@
+#ifndef __PURITYCHECKER_H
+#define __PURITYCHECKER_H
+
+#include <memory>
+#include <set>
+#include "Interpreter.hpp"
+#include "MemoCache.hpp"
+
+class LoxFunction;
+
+// Decides whether a function can be called from several threads at once.
+// It is conservative: the function may only assign to its own locals,
+// must not set fields or list/map elements, print or declare classes,
+// and may only call global or captured functions that pass the same
+// check and natives marked pure. Method calls and calls through locals
+// are rejected because their target is not known before the call.
+//
+// For memoization the function must also give the same result whenever
+// it is called with the same arguments, so it may not read variables
+// outside its own body, `this` or `super`, and may not call natives
+// (clock answers differently on every call). The variables its callees
+// were found in are collected in `callees` so the cache can tell when
+// one of them is rebound.
+class PurityChecker : public ExprVisitor, public StmtVisitor {
+  Interpreter& interpreter;
+  // Functions already accepted, or being checked further up the stack
+  // (recursion is assumed pure until shown otherwise).
+  std::set<const LoxFunction*> checked;
+  const LoxFunction* function = nullptr;
+  // Environments between the code being checked and the function's
+  // closure: 0 for the parameters, one more per block or nested function.
+  int depth = 0;
+  bool pure = true;
+  bool memoizing;
+
+public:
+  PurityChecker(Interpreter& interpreter, bool memoizing = false)
+    : interpreter{interpreter}, memoizing{memoizing} {}
+
+  bool isPure(const LoxFunction& function);
+  // Every function the checked ones call, including themselves when
+  // they recurse.
+  std::vector<MemoCache::Callee> callees;
+
+  std::any visitBlockStmt(Block& stmt) override;
+  std::any visitExpressionStmt(Expression& stmt) override;
+  std::any visitFunctionStmt(Function& stmt) override;
+  std::any visitIfStmt(If& stmt) override;
+  std::any visitPrintStmt(Print& stmt) override;
+  std::any visitClassStmt(Class& stmt) override;
+  std::any visitReturnStmt(Return& stmt) override;
+  std::any visitVarStmt(Var& stmt) override;
+  std::any visitWhileStmt(While& stmt) override;
+  std::any visitForStmt(For& stmt) override;
+
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
+private:
+  void check(const std::vector<std::shared_ptr<Stmt>>& statements);
+  void check(const std::shared_ptr<Stmt>& stmt);
+  void check(const std::shared_ptr<Expr>& expr);
+  bool isPureCallee(const std::shared_ptr<Variable>& callee);
+};
+
+#endif
@@ -7,73 +7,73 @@ void Resolver::resolve(std::vector<std::shared_ptr<Stmt>>& statements) {
   }
 }
 
-void Resolver::resolve(std::shared_ptr<Stmt> stmt) {
+void Resolver::resolve(const std::shared_ptr<Stmt>& stmt) {
   stmt->accept(*this);
 }
 
-void Resolver::resolve(std::shared_ptr<Expr> expr) {
+void Resolver::resolve(const std::shared_ptr<Expr>& expr) {
   expr->accept(*this);
 }
 
-std::any Resolver::visitBlockStmt(std::shared_ptr<Block> stmt) {
+std::any Resolver::visitBlockStmt(Block& stmt) {
   beginScope();
-  resolve(stmt->statements);
+  resolve(stmt.statements);
   endScope();
   return {};
 }
 
-std::any Resolver::visitExpressionStmt(std::shared_ptr<Expression> stmt) {
-  resolve(stmt->expression);
+std::any Resolver::visitExpressionStmt(Expression& stmt) {
+  resolve(stmt.expression);
   return {};
 }
 
-std::any Resolver::visitFunctionStmt(std::shared_ptr<Function> stmt) {
-  declare(stmt->name);
-  define(stmt->name);
+std::any Resolver::visitFunctionStmt(Function& stmt) {
+  declare(stmt.name);
+  define(stmt.name);
   resolveFunction(stmt, FunctionType::FUNCTION);
   return {};
 }
 
-std::any Resolver::visitIfStmt(std::shared_ptr<If> stmt) {
-  resolve(stmt->condition);
-  resolve(stmt->thenBranch);
-  if(stmt->elseBranch != nullptr) resolve(stmt->elseBranch);
+std::any Resolver::visitIfStmt(If& stmt) {
+  resolve(stmt.condition);
+  resolve(stmt.thenBranch);
+  if(stmt.elseBranch != nullptr) resolve(stmt.elseBranch);
   return {};
 }
 
-std::any Resolver::visitPrintStmt(std::shared_ptr<Print> stmt) {
-  resolve(stmt->expression);
+std::any Resolver::visitPrintStmt(Print& stmt) {
+  resolve(stmt.expression);
   return {};
 }
 
-std::any Resolver::visitReturnStmt(std::shared_ptr<Return> stmt) {
+std::any Resolver::visitReturnStmt(Return& stmt) {
   if(currentFunction == FunctionType::NONE) {
-    Lox::error(stmt->keyword, "Cannot return from top-level code.");
+    lox.error(stmt.keyword, "Cannot return from top-level code.");
   }
-  if(stmt->value != nullptr) {
+  if(stmt.value != nullptr) {
     if(currentFunction == FunctionType::INITIALIZER) {
-      Lox::error(stmt->keyword, "Cannot return a value from an initializer.");
+      lox.error(stmt.keyword, "Cannot return a value from an initializer.");
     }
-    resolve(stmt->value);
+    resolve(stmt.value);
   }
   return {};
 }
 
-std::any Resolver::visitClassStmt(std::shared_ptr<Class> stmt) {
+std::any Resolver::visitClassStmt(Class& stmt) {
   ClassType enclosingClass = currentClass;
   currentClass = ClassType::CLASS;
 
-  declare(stmt->name);
-  define(stmt->name);
-  if(stmt->superclass != nullptr && stmt->name.lexeme == stmt->superclass->name.lexeme) {
-    Lox::error(stmt->superclass->name, "A class cannot inherit from itself.");
+  declare(stmt.name);
+  define(stmt.name);
+  if(stmt.superclass != nullptr && stmt.name.lexeme == stmt.superclass->name.lexeme) {
+    lox.error(stmt.superclass->name, "A class cannot inherit from itself.");
   }
 
-  if(stmt->superclass != nullptr) {
+  if(stmt.superclass != nullptr) {
     currentClass = ClassType::SUBCLASS;
-    resolve(stmt->superclass);
+    resolve(stmt.superclass);
   }
-  if(stmt->superclass != nullptr) {
+  if(stmt.superclass != nullptr) {
     beginScope();
     scopes.back()["super"] = true;
   }
@@ -81,127 +81,159 @@ std::any Resolver::visitClassStmt(std::shared_ptr<Class> stmt) {
   beginScope();
   scopes.back()["this"] = true;
 
-  for(std::shared_ptr<Function> method : stmt->methods) {
+  for(const std::shared_ptr<Function>& method : stmt.methods) {
     FunctionType declaration = FunctionType::METHOD;
     if(method->name.lexeme == "init") {
       declaration = FunctionType::INITIALIZER;
     }
-    resolveFunction(method, declaration);
+    resolveFunction(*method, declaration);
   }
   endScope();
-  if(stmt->superclass != nullptr) endScope();
+  if(stmt.superclass != nullptr) endScope();
   currentClass = enclosingClass;
   return {};
 }
 
-std::any Resolver::visitSuperExpr(std::shared_ptr<Super> expr) {
+std::any Resolver::visitSuperExpr(Super& expr) {
   if(currentClass == ClassType::NONE) {
-    Lox::error(expr->keyword, "Cannot use 'super' outside of a class.");
+    lox.error(expr.keyword, "Cannot use 'super' outside of a class.");
   } else if(currentClass != ClassType::SUBCLASS) {
-    Lox::error(expr->keyword, "Cannot use 'super' in a class with no superclass.");
+    lox.error(expr.keyword, "Cannot use 'super' in a class with no superclass.");
   }
-  resolveLocal(expr, expr->keyword);
+  resolveLocal(expr.depth, expr.keyword);
   return {};
 }
 
-std::any Resolver::visitVarStmt(std::shared_ptr<Var> stmt) {
-  declare(stmt->name);
-  if(stmt->initializer != nullptr) {
-    resolve(stmt->initializer);
+std::any Resolver::visitVarStmt(Var& stmt) {
+  declare(stmt.name);
+  if(stmt.initializer != nullptr) {
+    resolve(stmt.initializer);
   }
-  define(stmt->name);
+  define(stmt.name);
   return {};
 }
 
-std::any Resolver::visitWhileStmt(std::shared_ptr<While> stmt) {
-  resolve(stmt->condition);
-  resolve(stmt->body);
+std::any Resolver::visitWhileStmt(While& stmt) {
+  resolve(stmt.condition);
+  resolve(stmt.body);
   return {};
 }
 
-std::any Resolver::visitAssignExpr(std::shared_ptr<Assign> expr) {
-  resolve(expr->value);
-  resolveLocal(expr, expr->name);
+std::any Resolver::visitForStmt(For& stmt) {
+  if(stmt.initializer != nullptr) {
+    beginScope();
+    resolve(stmt.initializer);
+  }
+  resolve(stmt.condition);
+  resolve(stmt.body);
+  if(stmt.increment != nullptr) resolve(stmt.increment);
+  if(stmt.initializer != nullptr) endScope();
+  return {};
+}
+
+std::any Resolver::visitAssignExpr(Assign& expr) {
+  resolve(expr.value);
+  resolveLocal(expr.depth, expr.name);
   return {};
 }
 
-std::any Resolver::visitBinaryExpr(std::shared_ptr<Binary> expr) {
-  resolve(expr->left);
-  resolve(expr->right);
+std::any Resolver::visitBinaryExpr(Binary& expr) {
+  resolve(expr.left);
+  resolve(expr.right);
   return {};
 }
 
-std::any Resolver::visitCallExpr(std::shared_ptr<Call> expr) {
-  resolve(expr->callee);
-  for(std::shared_ptr<Expr> argument : expr->arguments) {
+std::any Resolver::visitCallExpr(Call& expr) {
+  resolve(expr.callee);
+  for(const std::shared_ptr<Expr>& argument : expr.arguments) {
     resolve(argument);
   }
   return {};
 }
 
-std::any Resolver::visitGroupingExpr(std::shared_ptr<Grouping> expr) {
-  resolve(expr->expression);
+std::any Resolver::visitGroupingExpr(Grouping& expr) {
+  resolve(expr.expression);
   return {};
 }
 
-std::any Resolver::visitLiteralExpr(std::shared_ptr<Literal> expr) {
+std::any Resolver::visitLiteralExpr(Literal& expr) {
   return {};
 }
 
-std::any Resolver::visitLogicalExpr(std::shared_ptr<Logical> expr) {
-  resolve(expr->left);
-  resolve(expr->right);
+std::any Resolver::visitLogicalExpr(Logical& expr) {
+  resolve(expr.left);
+  resolve(expr.right);
   return {};
 }
 
-std::any Resolver::visitUnaryExpr(std::shared_ptr<Unary> expr) {
-  resolve(expr->right);
+std::any Resolver::visitUnaryExpr(Unary& expr) {
+  resolve(expr.right);
   return {};
 }
 
-std::any Resolver::visitVariableExpr(std::shared_ptr<Variable> expr) {
+std::any Resolver::visitVariableExpr(Variable& expr) {
   if(!scopes.empty()) {
     auto& scope = scopes.back();
-    auto elem = scope.find(expr->name.lexeme);
+    auto elem = scope.find(expr.name.lexeme);
     if(elem != scope.end() && elem->second == false) {
-      Lox::error(expr->name, "Cannot read local variable in its own initializer.");
+      lox.error(expr.name, "Cannot read local variable in its own initializer.");
     }
   }
-  resolveLocal(expr, expr->name);
+  resolveLocal(expr.depth, expr.name);
+  return {};
+}
+
+std::any Resolver::visitGetExpr(Get& expr) {
+  resolve(expr.object);
   return {};
 }
 
-std::any Resolver::visitGetExpr(std::shared_ptr<Get> expr) {
-  resolve(expr->object);
+std::any Resolver::visitSetExpr(Set& expr) {
+  resolve(expr.value);
+  resolve(expr.object);
   return {};
 }
 
-std::any Resolver::visitSetExpr(std::shared_ptr<Set> expr) {
-  resolve(expr->value);
-  resolve(expr->object);
+std::any Resolver::visitIndexExpr(Index& expr) {
+  resolve(expr.object);
+  resolve(expr.index);
+  return {};
+}
+
+std::any Resolver::visitSetIndexExpr(SetIndex& expr) {
+  resolve(expr.value);
+  resolve(expr.object);
+  resolve(expr.index);
+  return {};
+}
+
+std::any Resolver::visitListLiteralExpr(ListLiteral& expr) {
+  for(const std::shared_ptr<Expr>& element : expr.elements) {
+    resolve(element);
+  }
   return {};
 }
 
-std::any Resolver::visitThisExpr(std::shared_ptr<This> expr) {
+std::any Resolver::visitThisExpr(This& expr) {
   if (currentClass == ClassType::NONE) {
-    Lox::error(expr->keyword,
+    lox.error(expr.keyword,
         "Can't use 'this' outside of a class.");
     return {};
   }
 
-  resolveLocal(expr, expr->keyword);
+  resolveLocal(expr.depth, expr.keyword);
   return {};
 }
 
-void Resolver::resolveFunction(std::shared_ptr<Function> function, FunctionType type) {
+void Resolver::resolveFunction(Function& function, FunctionType type) {
   FunctionType enclosingFunction = currentFunction;
   currentFunction = type;
   beginScope();
-  for(Token param : function->params) {
+  for(const Token& param : function.params) {
     declare(param);
     define(param);
   }
-  resolve(function->body);
+  resolve(function.body);
   endScope();
   currentFunction = enclosingFunction;
 }
@@ -218,7 +250,7 @@ void Resolver::declare(const Token& name) {
   if(scopes.empty()) return;
   std::map<std::string, bool>& scope = scopes.back();
   if(scope.find(name.lexeme) != scope.end()) {
-    Lox::error(name, "Variable with this name already declared in this scope.");
+    lox.error(name, "Variable with this name already declared in this scope.");
   }
   scope[name.lexeme] = false;
 }
@@ -228,10 +260,10 @@ void Resolver::define(const Token& name) {
   scopes.back()[name.lexeme] = true;
 }
 
-void Resolver::resolveLocal(std::shared_ptr<Expr> expr, const Token& name) {
+void Resolver::resolveLocal(int& depth, const Token& name) {
   for(int i = scopes.size() - 1; i >= 0; i--) {
     if(scopes.at(i).find(name.lexeme) != scopes.at(i).end()) {
-      interpreter.resolve(expr, scopes.size() - 1 - i);
+      depth = scopes.size() - 1 - i;
       return;
     }
   }
@@ -3,7 +3,10 @@
 #include <map>
 #include "Interpreter.hpp"
 
+class Lox;
+
 class Resolver: public ExprVisitor, public StmtVisitor {
+  Lox& lox;
   Interpreter& interpreter;
   std::vector<std::map<std::string, bool>> scopes;
 
@@ -24,39 +27,43 @@ class Resolver: public ExprVisitor, public StmtVisitor {
   ClassType currentClass = ClassType::NONE; 
 
 public:
-  Resolver(Interpreter& interpreter)
-    : interpreter{interpreter}
+  Resolver(Lox& lox, Interpreter& interpreter)
+    : lox{lox}, interpreter{interpreter}
   {}
   void resolve(std::vector<std::shared_ptr<Stmt>>& statements);
-  std::any visitBlockStmt(std::shared_ptr<Block> stmt) override;
-  std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) override;
-  std::any visitFunctionStmt(std::shared_ptr<Function> stmt) override;
-  std::any visitIfStmt(std::shared_ptr<If> stmt) override;
-  std::any visitPrintStmt(std::shared_ptr<Print> stmt) override;
-  std::any visitClassStmt(std::shared_ptr<Class> stmt) override;
-  std::any visitReturnStmt(std::shared_ptr<Return> stmt) override;
-  std::any visitVarStmt(std::shared_ptr<Var> stmt) override;
-  std::any visitWhileStmt(std::shared_ptr<While> stmt) override;
+  std::any visitBlockStmt(Block& stmt) override;
+  std::any visitExpressionStmt(Expression& stmt) override;
+  std::any visitFunctionStmt(Function& stmt) override;
+  std::any visitIfStmt(If& stmt) override;
+  std::any visitPrintStmt(Print& stmt) override;
+  std::any visitClassStmt(Class& stmt) override;
+  std::any visitReturnStmt(Return& stmt) override;
+  std::any visitVarStmt(Var& stmt) override;
+  std::any visitWhileStmt(While& stmt) override;
+  std::any visitForStmt(For& stmt) override;
 
-  std::any visitAssignExpr(std::shared_ptr<Assign> expr) override;
-  std::any visitBinaryExpr(std::shared_ptr<Binary> expr) override;
-  std::any visitCallExpr(std::shared_ptr<Call> expr) override;
-  std::any visitGroupingExpr(std::shared_ptr<Grouping> expr) override;
-  std::any visitLiteralExpr(std::shared_ptr<Literal> expr) override;
-  std::any visitLogicalExpr(std::shared_ptr<Logical> expr) override;
-  std::any visitUnaryExpr(std::shared_ptr<Unary> expr) override;
-  std::any visitGetExpr(std::shared_ptr<Get> expr) override;
-  std::any visitSetExpr(std::shared_ptr<Set> expr) override;
-  std::any visitThisExpr(std::shared_ptr<This> expr) override;
-  std::any visitSuperExpr(std::shared_ptr<Super> expr) override;
-  std::any visitVariableExpr(std::shared_ptr<Variable> expr) override;
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
 private:
-  void resolve(std::shared_ptr<Stmt> stmt);
-  void resolve(std::shared_ptr<Expr> expr);
-  void resolveFunction(std::shared_ptr<Function> function, FunctionType type);
+  void resolve(const std::shared_ptr<Stmt>& stmt);
+  void resolve(const std::shared_ptr<Expr>& expr);
+  void resolveFunction(Function& function, FunctionType type);
   void beginScope();
   void endScope();
   void declare(const Token& name);
   void define(const Token& name);
-  void resolveLocal(std::shared_ptr<Expr> expr, const Token& name);
+  void resolveLocal(int& depth, const Token& name);
 };
@@ -1,7 +1,7 @@
 #include "Scanner.hpp"
 #include "Lox.hpp"
 
-std::map<std::string, TokenType> Scanner::keywords = {
+const std::map<std::string, TokenType> Scanner::keywords = {
   {"and", TokenType::AND},
   {"class", TokenType::CLASS},
   {"else", TokenType::ELSE},
@@ -25,6 +25,7 @@ std::vector<Token>& Scanner::scanTokens() {
     start = current; 
     scanToken();
   }
+  if(chunkMode) return tokens;
   tokens.emplace_back(TokenType::END_OF_FILE, "", nullptr, line);
   return tokens;
 }
@@ -53,6 +54,8 @@ void Scanner::scanToken() {
     case ')': addToken(TokenType::RIGHT_PAREN); break;
     case '{': addToken(TokenType::LEFT_BRACE); break;
     case '}': addToken(TokenType::RIGHT_BRACE); break;
+    case '[': addToken(TokenType::LEFT_BRACKET); break;
+    case ']': addToken(TokenType::RIGHT_BRACKET); break;
     case ',': addToken(TokenType::COMMA); break;
     case '.': addToken(TokenType::DOT); break;
     case '-': addToken(TokenType::MINUS); break;
@@ -96,11 +99,19 @@ void Scanner::scanToken() {
     } else if(isAlpha(c)) {
       identifier();
     } else {
-      Lox::error(line, "Unexpected character.");
+      error(line, "Unexpected character.");
     }
   }
 }
 
+void Scanner::error(int line, const std::string& message) {
+  if(chunkMode) {
+    errors.emplace_back(line, message);
+  } else {
+    lox.error(line, message);
+  }
+}
+
 bool Scanner::isAtEnd() {
   return current >= content.length();
 }
@@ -123,13 +134,17 @@ char Scanner::peekNext() {
 }
 
 void Scanner::string() {
+  int startLine = line;
   while(peek() != '"' && !isAtEnd()) {
     if(peek() == '\n') line++;
     consume();
   }
 
   if(isAtEnd()) {
-    Lox::error(line, "Unterminated string.");
+    endsInString = true;
+    stringStart = start;
+    stringLine = startLine;
+    error(line, "Unterminated string.");
     return;
   }
   // The closing paren
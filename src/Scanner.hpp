@@ -5,21 +5,37 @@
 #include <map>
 #include <vector>
 
+class Lox;
+
 class Scanner {
+  friend class ParallelScanner;
 private:
-  static std::map<std::string, TokenType> keywords;
+  static const std::map<std::string, TokenType> keywords;
+  Lox& lox;
   std::string content;
   int current;
   int start;
   int line;
 
+  // Chunk mode is used by ParallelScanner: errors are queued instead of
+  // reported, no END_OF_FILE token is emitted and a string that runs off
+  // the end of the chunk is remembered so the next chunk can be rescanned.
+  bool chunkMode = false;
+  std::vector<std::pair<int, std::string>> errors;
+  bool endsInString = false;
+  int stringStart = 0;
+  int stringLine = 0;
+
 public:
   std::vector<Token> tokens;
   Scanner() = delete;
-  Scanner(std::string content)
-    : content(std::move(content)), start(0), current(0), line(1) {}
+  Scanner(Lox& lox, std::string content)
+    : lox(lox), content(std::move(content)), start(0), current(0), line(1) {}
+  Scanner(Lox& lox, std::string content, int line)
+    : lox(lox), content(std::move(content)), start(0), current(0), line(line) {}
   std::vector<Token>& scanTokens();
 private:
+  void error(int line, const std::string& message);
   char consume();
   char peek();
   char peekNext();
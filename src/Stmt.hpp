@@ -8,26 +8,30 @@
 
 #include "Expr.hpp"
 
+struct JitCode;
+struct ClosureBody;
 struct Block;
 struct Expression;
 struct Function;
 struct If;
 struct Class;
 struct While;
+struct For;
 struct Return;
 struct Print;
 struct Var;
 
 struct StmtVisitor {
-  virtual std::any visitBlockStmt(std::shared_ptr<Block> stmt) = 0;
-  virtual std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) = 0;
-  virtual std::any visitIfStmt(std::shared_ptr<If> stmt) = 0;
-  virtual std::any visitPrintStmt(std::shared_ptr<Print> stmt) = 0;
-  virtual std::any visitClassStmt(std::shared_ptr<Class> stmt) = 0;
-  virtual std::any visitVarStmt(std::shared_ptr<Var> stmt) = 0;
-  virtual std::any visitWhileStmt(std::shared_ptr<While> stmt) = 0;
-  virtual std::any visitFunctionStmt(std::shared_ptr<Function> stmt) = 0;
-  virtual std::any visitReturnStmt(std::shared_ptr<Return> stmt) = 0;
+  virtual std::any visitBlockStmt(Block& stmt) = 0;
+  virtual std::any visitExpressionStmt(Expression& stmt) = 0;
+  virtual std::any visitIfStmt(If& stmt) = 0;
+  virtual std::any visitPrintStmt(Print& stmt) = 0;
+  virtual std::any visitClassStmt(Class& stmt) = 0;
+  virtual std::any visitVarStmt(Var& stmt) = 0;
+  virtual std::any visitWhileStmt(While& stmt) = 0;
+  virtual std::any visitForStmt(For& stmt) = 0;
+  virtual std::any visitFunctionStmt(Function& stmt) = 0;
+  virtual std::any visitReturnStmt(Return& stmt) = 0;
   virtual ~StmtVisitor() = default;
 };
 
@@ -35,116 +39,158 @@ struct Stmt {
   virtual std::any accept(StmtVisitor& visitor) = 0;
 };
 
-struct Block: Stmt, public std::enable_shared_from_this<Block> {
+struct Block: Stmt {
   Block(std::vector<std::shared_ptr<Stmt>> statements)
     : statements{std::move(statements)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitBlockStmt(shared_from_this());
+    return visitor.visitBlockStmt(*this);
   }
 
   std::vector<std::shared_ptr<Stmt>> statements;
 };
 
-struct Expression: Stmt, public std::enable_shared_from_this<Expression> {
+struct Expression: Stmt {
   Expression(std::shared_ptr<Expr> expression)
     : expression{std::move(expression)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitExpressionStmt(shared_from_this());
+    return visitor.visitExpressionStmt(*this);
   }
 
   std::shared_ptr<Expr> expression;
 };
 
-struct If: Stmt, public std::enable_shared_from_this<If> {
+struct If: Stmt {
   If(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> thenBranch, std::shared_ptr<Stmt> elseBranch)
     : condition{std::move(condition)}, thenBranch{std::move(thenBranch)}, elseBranch{std::move(elseBranch)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitIfStmt(shared_from_this());
+    return visitor.visitIfStmt(*this);
   }
 
   std::shared_ptr<Expr> condition;
   std::shared_ptr<Stmt> thenBranch;
   std::shared_ptr<Stmt> elseBranch;
+  StaticType conditionType = StaticType::UNKNOWN;
 };
 
-struct Print: Stmt, public std::enable_shared_from_this<Print> {
+struct Print: Stmt {
   Print(std::shared_ptr<Expr> expression)
     : expression{std::move(expression)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitPrintStmt(shared_from_this());
+    return visitor.visitPrintStmt(*this);
   }
 
   std::shared_ptr<Expr> expression;
 };
 
-struct Var: Stmt, public std::enable_shared_from_this<Var> {
+struct Var: Stmt {
   Var(Token name, std::shared_ptr<Expr> initializer)
     : name{std::move(name)}, initializer{std::move(initializer)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitVarStmt(shared_from_this());
+    return visitor.visitVarStmt(*this);
   }
 
   Token name;
   std::shared_ptr<Expr> initializer;
 };
 
-struct While : Stmt, public std::enable_shared_from_this<While> {
+struct While : Stmt {
   While(std::shared_ptr<Expr> condition, std::shared_ptr<Stmt> body)
     : condition{std::move(condition)}, body{std::move(body)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitWhileStmt(shared_from_this());
+    return visitor.visitWhileStmt(*this);
   }
 
   std::shared_ptr<Expr> condition;
   std::shared_ptr<Stmt> body;
+  StaticType conditionType = StaticType::UNKNOWN;
 };
 
+// A for loop. The initializer, when there is one, gets a scope that lasts
+// for the whole loop and holds the loop variable; the condition and the
+// increment are evaluated in it. A body that is a block gets a scope of
+// its own, but unless a function or method is declared in it nothing can
+// hold on to that scope after an iteration, and `reuseBodyScope` lets one
+// environment serve every iteration.
+struct For : Stmt {
+  For(std::shared_ptr<Stmt> initializer, std::shared_ptr<Expr> condition, std::shared_ptr<Expr> increment, std::shared_ptr<Stmt> body, bool reuseBodyScope)
+    : initializer{std::move(initializer)}, condition{std::move(condition)}, increment{std::move(increment)}, body{std::move(body)}, reuseBodyScope{reuseBodyScope}
+  {}
+
+  std::any accept(StmtVisitor& visitor) override {
+    return visitor.visitForStmt(*this);
+  }
+
+  // The initializer and the increment may be null. A missing condition is
+  // parsed as `true`.
+  std::shared_ptr<Stmt> initializer;
+  std::shared_ptr<Expr> condition;
+  std::shared_ptr<Expr> increment;
+  std::shared_ptr<Stmt> body;
+  bool reuseBodyScope;
+  StaticType conditionType = StaticType::UNKNOWN;
+};
+
+// The only node that hands out shared pointers to itself: each LoxFunction
+// keeps its declaration alive.
 struct Function : Stmt, public std::enable_shared_from_this<Function> {
   Function(Token name, std::vector<Token> params, std::vector<std::shared_ptr<Stmt>> body)
     : name{std::move(name)}, params{std::move(params)}, body{std::move(body)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitFunctionStmt(shared_from_this());
+    return visitor.visitFunctionStmt(*this);
   }
 
   Token name;
   std::vector<Token> params;
   std::vector<std::shared_ptr<Stmt>> body;
+  // Filled in by the JIT once a function with this body gets hot: its
+  // native code, or a note that the body cannot be compiled. The code is
+  // freed with the declaration, e.g. once a REPL line redefines it.
+  std::shared_ptr<JitCode> jitCode;
+  bool jitFailed = false;
+  // The body lowered by the ClosureCompiler, when that engine runs it.
+  std::shared_ptr<ClosureBody> closureBody;
+  // Whether a function or method is declared anywhere in the body. Only
+  // then can a closure keep the environment of a call alive.
+  bool declaresClosures = false;
+  // Declared `pure fun`: its results are cached when PurityChecker agrees
+  // it is pure, even without --memoize.
+  bool pure = false;
 };
 
-struct Return : Stmt, public std::enable_shared_from_this<Return> {
+struct Return : Stmt {
   Return(Token keyword, std::shared_ptr<Expr> value)
     : keyword{std::move(keyword)}, value{std::move(value)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitReturnStmt(shared_from_this());
+    return visitor.visitReturnStmt(*this);
   }
 
   Token keyword;
   std::shared_ptr<Expr> value;
 };
 
-struct Class : Stmt, public std::enable_shared_from_this<Class> {
+struct Class : Stmt {
   Class(Token name, std::shared_ptr<Variable> superclass, std::vector<std::shared_ptr<Function>> methods)
     : name{std::move(name)}, superclass{std::move(superclass)}, methods{std::move(methods)}
   {}
 
   std::any accept(StmtVisitor& visitor) override {
-    return visitor.visitClassStmt(shared_from_this());
+    return visitor.visitClassStmt(*this);
   }
 
   Token name;
@@ -2,6 +2,7 @@
 std::string toString(TokenType type) {
   const std::string strings[] = {
     "LEFT_PAREN", "RIGHT_PAREN", "LEFT_BRACE", "RIGHT_BRACE",
+    "LEFT_BRACKET", "RIGHT_BRACKET",
     "COMMA", "DOT", "MINUS", "PLUS", "SEMICOLON", "SLASH", "STAR",
     "BANG", "BANG_EQUAL",
     "EQUAL", "EQUAL_EQUAL",
@@ -5,6 +5,7 @@
 enum TokenType {
   // Single-character tokens
   LEFT_PAREN, RIGHT_PAREN, LEFT_BRACE, RIGHT_BRACE,
+  LEFT_BRACKET, RIGHT_BRACKET,
   COMMA, DOT, MINUS, PLUS, SEMICOLON, SLASH, STAR,
 
   // One or two character tokens
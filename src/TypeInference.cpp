@@ -0,0 +1,358 @@
+#include "TypeInference.hpp"
+#include "LoxString.hpp"
+
+TypeInference TypeInference::prove(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  TypeInference inference;
+  inference.collecting = true;
+  inference.analyze(statements);
+  inference.collecting = false;
+  inference.types.clear();
+  inference.sites.clear();
+  inference.analyze(statements);
+
+  inference.checks = inference.sites.size();
+  for(const auto& [node, proven] : inference.sites) {
+    if(proven) inference.eliminated++;
+  }
+  return inference;
+}
+
+void TypeInference::analyze(const std::vector<std::shared_ptr<Stmt>>& statements) {
+  for(const std::shared_ptr<Stmt>& stmt : statements) {
+    analyze(stmt);
+  }
+}
+
+void TypeInference::analyze(const std::shared_ptr<Stmt>& stmt) {
+  stmt->accept(*this);
+}
+
+StaticType TypeInference::infer(const std::shared_ptr<Expr>& expr) {
+  return std::any_cast<StaticType>(expr->accept(*this));
+}
+
+void TypeInference::analyzeFunction(Function& declaration) {
+  // The body runs whenever the function is called, so it starts from
+  // nothing proven and leaves the enclosing code's types alone.
+  State enclosingTypes = std::move(types);
+  types.clear();
+  function++;
+  beginScope();
+  for(const Token& param : declaration.params) {
+    declare(param, StaticType::UNKNOWN);
+  }
+  analyze(declaration.body);
+  endScope();
+  function--;
+  types = std::move(enclosingTypes);
+}
+
+void TypeInference::beginScope() {
+  scopes.push_back(Scope{{}, function});
+}
+
+void TypeInference::endScope() {
+  for(const auto& [name, slot] : scopes.back().names) {
+    types.erase(slot);
+  }
+  scopes.pop_back();
+}
+
+void TypeInference::declare(const Token& name, StaticType type) {
+  if(scopes.empty()) return;
+  scopes.back().names[name.lexeme] = &name;
+  set(&name, type);
+}
+
+TypeInference::Slot TypeInference::lookUp(const std::string& name, int depth, bool& enclosing) {
+  int index = static_cast<int>(scopes.size()) - 1 - depth;
+  if(depth < 0 || index < 0) return nullptr;
+  const Scope& scope = scopes[index];
+  auto slot = scope.names.find(name);
+  if(slot == scope.names.end()) return nullptr;
+  enclosing = scope.function != function;
+  return slot->second;
+}
+
+void TypeInference::set(Slot slot, StaticType type) {
+  if(type == StaticType::UNKNOWN) {
+    types.erase(slot);
+  } else {
+    types[slot] = type;
+  }
+}
+
+TypeInference::State TypeInference::join(const State& a, const State& b) {
+  State joined;
+  for(const auto& [slot, type] : a) {
+    auto other = b.find(slot);
+    if(other != b.end() && other->second == type) joined.emplace(slot, type);
+  }
+  return joined;
+}
+
+std::any TypeInference::visitBlockStmt(Block& stmt) {
+  beginScope();
+  analyze(stmt.statements);
+  endScope();
+  return {};
+}
+
+std::any TypeInference::visitExpressionStmt(Expression& stmt) {
+  infer(stmt.expression);
+  return {};
+}
+
+std::any TypeInference::visitFunctionStmt(Function& stmt) {
+  declare(stmt.name, StaticType::UNKNOWN);
+  analyzeFunction(stmt);
+  return {};
+}
+
+std::any TypeInference::visitIfStmt(If& stmt) {
+  stmt.conditionType = infer(stmt.condition);
+  site(&stmt, stmt.conditionType == StaticType::BOOL);
+  State otherwise = types;
+  analyze(stmt.thenBranch);
+  std::swap(types, otherwise);
+  if(stmt.elseBranch != nullptr) analyze(stmt.elseBranch);
+  types = join(types, otherwise);
+  return {};
+}
+
+std::any TypeInference::visitPrintStmt(Print& stmt) {
+  infer(stmt.expression);
+  return {};
+}
+
+std::any TypeInference::visitClassStmt(Class& stmt) {
+  declare(stmt.name, StaticType::UNKNOWN);
+  if(stmt.superclass != nullptr) {
+    infer(stmt.superclass);
+    beginScope();
+    scopes.back().names["super"] = nullptr;
+  }
+  beginScope();
+  scopes.back().names["this"] = nullptr;
+  for(const std::shared_ptr<Function>& method : stmt.methods) {
+    analyzeFunction(*method);
+  }
+  endScope();
+  if(stmt.superclass != nullptr) endScope();
+  return {};
+}
+
+std::any TypeInference::visitReturnStmt(Return& stmt) {
+  if(stmt.value != nullptr) infer(stmt.value);
+  return {};
+}
+
+std::any TypeInference::visitVarStmt(Var& stmt) {
+  StaticType type = StaticType::NIL;
+  if(stmt.initializer != nullptr) type = infer(stmt.initializer);
+  declare(stmt.name, type);
+  return {};
+}
+
+std::any TypeInference::visitWhileStmt(While& stmt) {
+  // Walk the loop until the types at its head stop changing. Each walk
+  // can only forget types, so this ends after a few rounds.
+  while(true) {
+    State head = types;
+    stmt.conditionType = infer(stmt.condition);
+    site(&stmt, stmt.conditionType == StaticType::BOOL);
+    State exit = types;
+    analyze(stmt.body);
+    State next = join(head, types);
+    if(collecting || next == head) {
+      types = std::move(exit);
+      break;
+    }
+    types = std::move(next);
+  }
+  return {};
+}
+
+std::any TypeInference::visitForStmt(For& stmt) {
+  if(stmt.initializer != nullptr) {
+    beginScope();
+    analyze(stmt.initializer);
+  }
+  // The same fixpoint as a while loop whose body ends with the increment.
+  while(true) {
+    State head = types;
+    stmt.conditionType = infer(stmt.condition);
+    site(&stmt, stmt.conditionType == StaticType::BOOL);
+    State exit = types;
+    analyze(stmt.body);
+    if(stmt.increment != nullptr) infer(stmt.increment);
+    State next = join(head, types);
+    if(collecting || next == head) {
+      types = std::move(exit);
+      break;
+    }
+    types = std::move(next);
+  }
+  if(stmt.initializer != nullptr) endScope();
+  return {};
+}
+
+std::any TypeInference::visitAssignExpr(Assign& expr) {
+  StaticType type = infer(expr.value);
+  bool enclosing = false;
+  Slot slot = lookUp(expr.name.lexeme, expr.depth, enclosing);
+  if(slot == nullptr) return type;
+  if(enclosing) {
+    if(collecting) captured.insert(slot);
+  } else {
+    set(slot, type);
+  }
+  return type;
+}
+
+static Specialization numberSpecialization(TokenType op) {
+  switch(op) {
+    case TokenType::PLUS: return Specialization::NUMBER_ADD;
+    case TokenType::MINUS: return Specialization::NUMBER_SUBTRACT;
+    case TokenType::STAR: return Specialization::NUMBER_MULTIPLY;
+    case TokenType::SLASH: return Specialization::NUMBER_DIVIDE;
+    case TokenType::LESS: return Specialization::NUMBER_LESS;
+    case TokenType::LESS_EQUAL: return Specialization::NUMBER_LESS_EQUAL;
+    case TokenType::GREATER: return Specialization::NUMBER_GREATER;
+    case TokenType::GREATER_EQUAL: return Specialization::NUMBER_GREATER_EQUAL;
+  }
+  return Specialization::UNINITIALIZED;
+}
+
+std::any TypeInference::visitBinaryExpr(Binary& expr) {
+  StaticType left = infer(expr.left);
+  StaticType right = infer(expr.right);
+  bool numbers = left == StaticType::NUMBER && right == StaticType::NUMBER;
+  StaticType result = StaticType::UNKNOWN;
+  StaticType proven = StaticType::UNKNOWN;
+  switch(expr.op.type) {
+    case TokenType::BANG_EQUAL:
+    case TokenType::EQUAL_EQUAL:
+      return StaticType::BOOL;
+    case TokenType::PLUS:
+      // Mixed operands throw, so one known side fixes the result.
+      if(left == right && (left == StaticType::NUMBER || left == StaticType::STRING)) proven = left;
+      if(left == StaticType::NUMBER || right == StaticType::NUMBER) result = StaticType::NUMBER;
+      else if(left == StaticType::STRING || right == StaticType::STRING) result = StaticType::STRING;
+      break;
+    case TokenType::MINUS:
+    case TokenType::STAR:
+    case TokenType::SLASH:
+      if(numbers) proven = StaticType::NUMBER;
+      result = StaticType::NUMBER;
+      break;
+    case TokenType::LESS:
+    case TokenType::LESS_EQUAL:
+    case TokenType::GREATER:
+    case TokenType::GREATER_EQUAL:
+      if(numbers) proven = StaticType::NUMBER;
+      result = StaticType::BOOL;
+      break;
+  }
+
+  expr.operandType = proven;
+  if(proven == StaticType::NUMBER) {
+    expr.specialization.current = numberSpecialization(expr.op.type);
+  } else if(proven == StaticType::STRING) {
+    expr.specialization.current = Specialization::STRING_CONCAT;
+  } else {
+    expr.specialization.current = Specialization::UNINITIALIZED;
+  }
+  site(&expr, proven != StaticType::UNKNOWN);
+  return result;
+}
+
+std::any TypeInference::visitCallExpr(Call& expr) {
+  infer(expr.callee);
+  for(const std::shared_ptr<Expr>& argument : expr.arguments) {
+    infer(argument);
+  }
+  site(&expr, false);
+  return StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitGroupingExpr(Grouping& expr) {
+  return infer(expr.expression);
+}
+
+std::any TypeInference::visitLiteralExpr(Literal& expr) {
+  const std::type_info& type = expr.value.type();
+  if(type == typeid(double)) return StaticType::NUMBER;
+  if(type == typeid(bool)) return StaticType::BOOL;
+  if(type == typeid(std::nullptr_t)) return StaticType::NIL;
+  if(type == typeid(std::shared_ptr<LoxString>)) return StaticType::STRING;
+  return StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitLogicalExpr(Logical& expr) {
+  expr.leftType = infer(expr.left);
+  site(&expr, expr.leftType == StaticType::BOOL);
+  // The right operand may not run.
+  State skipped = types;
+  StaticType right = infer(expr.right);
+  types = join(types, skipped);
+  return expr.leftType == right ? right : StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitUnaryExpr(Unary& expr) {
+  expr.operandType = infer(expr.right);
+  if(expr.op.type == TokenType::BANG) {
+    site(&expr, expr.operandType == StaticType::BOOL);
+    return StaticType::BOOL;
+  }
+  site(&expr, expr.operandType == StaticType::NUMBER);
+  return StaticType::NUMBER;
+}
+
+std::any TypeInference::visitGetExpr(Get& expr) {
+  infer(expr.object);
+  site(&expr, false);
+  return StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitSetExpr(Set& expr) {
+  infer(expr.object);
+  site(&expr, false);
+  return infer(expr.value);
+}
+
+std::any TypeInference::visitThisExpr(This& expr) {
+  return StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitSuperExpr(Super& expr) {
+  return StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitVariableExpr(Variable& expr) {
+  bool enclosing = false;
+  Slot slot = lookUp(expr.name.lexeme, expr.depth, enclosing);
+  if(slot == nullptr || enclosing || captured.count(slot)) return StaticType::UNKNOWN;
+  auto type = types.find(slot);
+  return type == types.end() ? StaticType::UNKNOWN : type->second;
+}
+
+std::any TypeInference::visitIndexExpr(Index& expr) {
+  infer(expr.object);
+  infer(expr.index);
+  return StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitSetIndexExpr(SetIndex& expr) {
+  infer(expr.object);
+  infer(expr.index);
+  infer(expr.value);
+  return StaticType::UNKNOWN;
+}
+
+std::any TypeInference::visitListLiteralExpr(ListLiteral& expr) {
+  for(const std::shared_ptr<Expr>& element : expr.elements) {
+    infer(element);
+  }
+  return StaticType::UNKNOWN;
+}
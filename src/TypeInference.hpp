@@ -0,0 +1,102 @@
+#ifndef __TYPEINFERENCE_H
+#define __TYPEINFERENCE_H
+
+#include <any>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Expr.hpp"
+#include "Stmt.hpp"
+
+// Proves the types of operands before a script runs, so the interpreter
+// can skip the checks it would otherwise make on every evaluation. Runs
+// after the parser has resolved variables and walks the tree in execution
+// order, tracking the type each local holds at each point: literals have
+// their own type, arithmetic yields numbers and comparisons yield bools,
+// and an `if` or a loop joins the types its paths leave behind. Globals,
+// parameters, call results and fields are never proven. Neither are
+// locals inside the functions nested in their own, or anywhere once a
+// nested function assigns them.
+//
+// Proven operands are recorded on the nodes (see StaticType). Binary
+// nodes whose operands are proven numbers or strings also start out
+// specialized, so the interpreter neither samples nor checks them.
+class TypeInference : public ExprVisitor, public StmtVisitor {
+  // Locals are identified by the token that declares them.
+  using Slot = const Token*;
+  struct Scope {
+    std::map<std::string, Slot> names;
+    int function;
+  };
+  using State = std::map<Slot, StaticType>;
+
+  std::vector<Scope> scopes;
+  // How many function bodies enclose the code being analyzed.
+  int function = 0;
+  // The proven type of each local at the current point. Locals that are
+  // not in the map are UNKNOWN.
+  State types;
+  // Locals assigned from a nested function, which may change them at any
+  // call. Found by a first walk over the script.
+  std::set<Slot> captured;
+  bool collecting = false;
+  // Every node that checks a type, and whether the check was proven
+  // unnecessary. Loop bodies are walked until their types settle; the
+  // last walk decides.
+  std::unordered_map<const void*, bool> sites;
+
+  void analyze(const std::vector<std::shared_ptr<Stmt>>& statements);
+  void analyze(const std::shared_ptr<Stmt>& stmt);
+  StaticType infer(const std::shared_ptr<Expr>& expr);
+  void analyzeFunction(Function& function);
+  void beginScope();
+  void endScope();
+  void declare(const Token& name, StaticType type);
+  // The slot a resolved variable refers to, or nullptr for globals.
+  // `enclosing` is set when the slot belongs to an enclosing function.
+  Slot lookUp(const std::string& name, int depth, bool& enclosing);
+  void set(Slot slot, StaticType type);
+  void site(const void* node, bool proven) { sites[node] = proven; }
+  static State join(const State& a, const State& b);
+public:
+  // Dynamic type checks in the script: operand checks of arithmetic and
+  // comparisons, truthiness tests, callee checks of calls and instance
+  // checks of property reads and writes. `eliminated` of them were
+  // proven away.
+  size_t checks = 0;
+  size_t eliminated = 0;
+
+  static TypeInference prove(const std::vector<std::shared_ptr<Stmt>>& statements);
+
+  std::any visitBlockStmt(Block& stmt) override;
+  std::any visitExpressionStmt(Expression& stmt) override;
+  std::any visitFunctionStmt(Function& stmt) override;
+  std::any visitIfStmt(If& stmt) override;
+  std::any visitPrintStmt(Print& stmt) override;
+  std::any visitClassStmt(Class& stmt) override;
+  std::any visitReturnStmt(Return& stmt) override;
+  std::any visitVarStmt(Var& stmt) override;
+  std::any visitWhileStmt(While& stmt) override;
+  std::any visitForStmt(For& stmt) override;
+
+  std::any visitAssignExpr(Assign& expr) override;
+  std::any visitBinaryExpr(Binary& expr) override;
+  std::any visitCallExpr(Call& expr) override;
+  std::any visitGroupingExpr(Grouping& expr) override;
+  std::any visitLiteralExpr(Literal& expr) override;
+  std::any visitLogicalExpr(Logical& expr) override;
+  std::any visitUnaryExpr(Unary& expr) override;
+  std::any visitGetExpr(Get& expr) override;
+  std::any visitSetExpr(Set& expr) override;
+  std::any visitThisExpr(This& expr) override;
+  std::any visitSuperExpr(Super& expr) override;
+  std::any visitVariableExpr(Variable& expr) override;
+  std::any visitIndexExpr(Index& expr) override;
+  std::any visitSetIndexExpr(SetIndex& expr) override;
+  std::any visitListLiteralExpr(ListLiteral& expr) override;
+};
+
+#endif
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <exception>
+#include "WorkStealingPool.hpp"
+#include "Interpreter.hpp"
+#include "LoxFunction.hpp"
+#include "LoxList.hpp"
+#include "LoxNative.hpp"
+#include "PurityChecker.hpp"
+#include "Environment.hpp"
+
+static uint64_t pack(uint64_t begin, uint64_t end) { return begin << 32 | end; }
+static size_t beginOf(uint64_t bounds) { return bounds >> 32; }
+static size_t endOf(uint64_t bounds) { return bounds & 0xffffffff; }
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+  for(unsigned worker = 1; worker < threads; worker++) {
+    this->threads.emplace_back([this, worker] { loop(worker); });
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeup.notify_all();
+  for(std::thread& thread : threads) thread.join();
+}
+
+WorkStealingPool& WorkStealingPool::shared() {
+  static WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+void WorkStealingPool::loop(unsigned worker) {
+  uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while(true) {
+    wakeup.wait(lock, [&] { return stopping || (job != nullptr && generation != seen); });
+    if(stopping) return;
+    seen = generation;
+    Job* current = job;
+    active++;
+    lock.unlock();
+    work(*current, worker);
+    lock.lock();
+    if(--active == 0) finished.notify_all();
+  }
+}
+
+void WorkStealingPool::work(Job& job, unsigned worker) {
+  Range& own = job.ranges[worker];
+  while(true) {
+    uint64_t bounds = own.bounds.load(std::memory_order_acquire);
+    size_t begin = beginOf(bounds), end = endOf(bounds);
+    if(begin < end) {
+      size_t take = std::min(end, begin + job.grain);
+      if(own.bounds.compare_exchange_weak(bounds, pack(take, end), std::memory_order_acq_rel)) {
+        job.body(worker, begin, take);
+      }
+      continue;
+    }
+    if(!steal(job, worker)) return;
+  }
+}
+
+bool WorkStealingPool::steal(Job& job, unsigned worker) {
+  size_t workers = job.ranges.size();
+  for(size_t i = 1; i < workers; i++) {
+    Range& victim = job.ranges[(worker + i) % workers];
+    uint64_t bounds = victim.bounds.load(std::memory_order_acquire);
+    while(beginOf(bounds) < endOf(bounds)) {
+      size_t begin = beginOf(bounds), end = endOf(bounds);
+      size_t middle = begin + (end - begin) / 2;
+      if(victim.bounds.compare_exchange_weak(bounds, pack(begin, middle), std::memory_order_acq_rel)) {
+        job.ranges[worker].bounds.store(pack(middle, end), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void WorkStealingPool::parallelFor(size_t count, size_t grain, const Body& body) {
+  std::unique_lock<std::mutex> exclusive(running, std::try_to_lock);
+  if(!exclusive || threads.empty() || count <= grain) {
+    body(0, 0, count);
+    return;
+  }
+
+  Job current(body, std::max<size_t>(grain, 1), workers());
+  size_t workers = current.ranges.size();
+  for(size_t i = 0; i < workers; i++) {
+    current.ranges[i].bounds.store(pack(count * i / workers, count * (i + 1) / workers), std::memory_order_relaxed);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &current;
+    generation++;
+  }
+  wakeup.notify_all();
+  work(current, 0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  job = nullptr;
+  finished.wait(lock, [&] { return active == 0; });
+}
+
+static std::shared_ptr<LoxList> asList(std::any& value, const std::string& function) {
+  if(value.type() != typeid(std::shared_ptr<LoxList>)) {
+    throw NativeError("First argument to '" + function + "' must be a list.");
+  }
+  return std::any_cast<std::shared_ptr<LoxList>>(value);
+}
+
+static std::shared_ptr<LoxFunction> asPureFunction(Interpreter& interpreter, std::any& value, int arity, const std::string& function) {
+  if(value.type() != typeid(std::shared_ptr<LoxFunction>)) {
+    throw NativeError("Second argument to '" + function + "' must be a function.");
+  }
+  auto callback = std::any_cast<std::shared_ptr<LoxFunction>>(value);
+  if(callback->arity() != arity) {
+    throw NativeError("Function passed to '" + function + "' must take " + std::to_string(arity) + " arguments.");
+  }
+  if(!PurityChecker(interpreter).isPure(*callback)) {
+    throw NativeError("Function passed to '" + function + "' must not write captured or global state.");
+  }
+  return callback;
+}
+
+// Runs body on the pool with one interpreter per worker. The first error
+// stops the loop and is rethrown on the calling thread.
+//
+// The calling thread runs its share on a worker interpreter too. The
+// calling interpreter specializes the nodes it runs, and those writes
+// would race with the other workers reading the same nodes.
+static void runParallel(Interpreter& interpreter, size_t count, 
+  const std::function<void(Interpreter&, size_t, size_t)>& body) {
+  if(count > 0xffffffff) throw NativeError("List is too long to process in parallel.");
+  WorkStealingPool& pool = WorkStealingPool::shared();
+  std::vector<std::unique_ptr<Interpreter>> workers;
+  for(unsigned i = 0; i < pool.workers(); i++) workers.push_back(interpreter.makeWorker());
+
+  std::atomic<bool> failed{false};
+  std::exception_ptr error;
+  std::mutex errorMutex;
+  size_t grain = std::max<size_t>(1, count / (pool.workers() * 32));
+  pool.parallelFor(count, grain, [&](unsigned worker, size_t begin, size_t end) {
+    if(failed.load(std::memory_order_relaxed)) return;
+    try {
+      body(*workers[worker], begin, end);
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if(!error) error = std::current_exception();
+      failed.store(true, std::memory_order_relaxed);
+    }
+  });
+  if(error) std::rethrow_exception(error);
+}
+
+void WorkStealingPool::defineNatives(Environment& globals) {
+  globals.define("parallelMap", std::make_shared<LoxNative>("parallelMap", 2,
+    [](Interpreter& interpreter, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxList> list = asList(arguments[0], "parallelMap");
+      std::shared_ptr<LoxFunction> callback = asPureFunction(interpreter, arguments[1], 1, "parallelMap");
+      const std::vector<std::any>& elements = list->elements;
+      std::vector<std::any> results(elements.size());
+      runParallel(interpreter, elements.size(), [&](Interpreter& worker, size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+          std::any argument = elements[i];
+          results[i] = callback->call(worker, {&argument, 1});
+        }
+      });
+      return std::make_shared<LoxList>(std::move(results));
+    }));
+
+  // Each chunk of the list is folded starting from init and the chunk
+  // results are then folded in order, so fn must be associative and init
+  // must be its identity (0 for +, 1 for *, and so on).
+  globals.define("parallelReduce", std::make_shared<LoxNative>("parallelReduce", 3,
+    [](Interpreter& interpreter, std::span<std::any> arguments) -> std::any {
+      std::shared_ptr<LoxList> list = asList(arguments[0], "parallelReduce");
+      std::shared_ptr<LoxFunction> callback = asPureFunction(interpreter, arguments[1], 2, "parallelReduce");
+      const std::vector<std::any>& elements = list->elements;
+      const std::any& init = arguments[2];
+      std::vector<std::pair<size_t, std::any>> partials;
+      std::mutex partialsMutex;
+      runParallel(interpreter, elements.size(), [&](Interpreter& worker, size_t begin, size_t end) {
+        std::any accumulator = init;
+        for(size_t i = begin; i < end; i++) {
+          std::any pair[] = {std::move(accumulator), elements[i]};
+          accumulator = callback->call(worker, pair);
+        }
+        std::lock_guard<std::mutex> lock(partialsMutex);
+        partials.emplace_back(begin, std::move(accumulator));
+      });
+      std::sort(partials.begin(), partials.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+      if(partials.empty()) return init;
+      std::any result = partials[0].second;
+      for(size_t i = 1; i < partials.size(); i++) {
+        std::any pair[] = {std::move(result), partials[i].second};
+        result = callback->call(interpreter, pair);
+      }
+      return result;
+    }));
+}
@@ -0,0 +1,69 @@
+#ifndef __WORKSTEALINGPOOL_H
+#define __WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Environment;
+
+// Runs parallel loops over index ranges. The range is split evenly
+// between the workers up front; a worker takes `grain` indices at a time
+// from the front of its own range and, when that is empty, steals the
+// back half of another worker's range. A range is one atomic word (begin
+// and end packed into 32 bits each), so taking and stealing are single
+// compare-and-swaps.
+//
+// The calling thread is worker 0. Only one loop runs at a time; a caller
+// that finds the pool busy runs its loop alone.
+class WorkStealingPool {
+public:
+  // Called with the worker number and a half-open index range. Must not
+  // throw.
+  using Body = std::function<void(unsigned worker, size_t begin, size_t end)>;
+private:
+  struct alignas(64) Range {
+    std::atomic<uint64_t> bounds{0};
+  };
+  struct Job {
+    const Body& body;
+    size_t grain;
+    std::vector<Range> ranges;
+    Job(const Body& body, size_t grain, size_t workers)
+      : body{body}, grain{grain}, ranges(workers) {}
+  };
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wakeup;
+  std::condition_variable finished;
+  Job* job = nullptr;
+  uint64_t generation = 0;
+  unsigned active = 0;
+  bool stopping = false;
+  std::mutex running;
+
+  void loop(unsigned worker);
+  static void work(Job& job, unsigned worker);
+  static bool steal(Job& job, unsigned worker);
+public:
+  WorkStealingPool(unsigned threads);
+  ~WorkStealingPool();
+  WorkStealingPool(WorkStealingPool& other) = delete;
+  WorkStealingPool& operator=(WorkStealingPool& other) = delete;
+
+  // One pool per process with a worker per hardware thread.
+  static WorkStealingPool& shared();
+  unsigned workers() const { return threads.size() + 1; }
+  // Runs body over [0, count). count must fit in 32 bits.
+  void parallelFor(size_t count, size_t grain, const Body& body);
+
+  // parallelMap and parallelReduce.
+  static void defineNatives(Environment& globals);
+};
+
+#endif
@@ -1,15 +1,41 @@
 #include <iostream>
+#include <vector>
 #include "Lox.hpp"
 
 int main(int argc, char* argv[]) {
-  if (argc == 1) {
-    Lox::runPrompt();   
-  } else if (argc == 2) {
-    std::string filePath = argv[1];
-    Lox::runFile(filePath);
+  Lox lox;
+  bool emitCpp = false;
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--line-buffered") {
+      lox.setLineBuffered(true);
+    } else if (arg == "--stats") {
+      lox.setStats(true);
+    } else if (arg == "--jit") {
+      lox.setJit(true);
+    } else if (arg == "--memoize") {
+      lox.setMemoize(true);
+    } else if (arg == "--engine=tree") {
+      lox.setEngine(Interpreter::Engine::TREE);
+    } else if (arg == "--engine=closure") {
+      lox.setEngine(Interpreter::Engine::CLOSURE);
+    } else if (arg == "--emit-cpp") {
+      emitCpp = true;
+    } else {
+      args.push_back(arg);
+    }
+  }
+
+  int status = 0;
+  if (args.empty()) {
+    lox.runPrompt();   
+  } else if (args.size() == 1) {
+    status = emitCpp ? lox.emitCpp(args[0]) : lox.runFile(args[0]);
   } else {
     std::cerr << "Invalid number of arguments.\n";
-    std::cerr << "Usage 'compiler <file_name>' or 'compiler'\n";
+    std::cerr << "Usage 'compiler [--line-buffered] [--stats] [--jit] [--memoize] [--engine=tree|closure] [--emit-cpp] <file_name>' or 'compiler'\n";
   }
-  return 0;
-}
\ No newline at end of file
+  lox.flush();
+  return status;
+}
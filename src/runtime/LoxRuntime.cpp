@@ -0,0 +1,164 @@
+#include <chrono>
+#include <iostream>
+#include "LoxRuntime.hpp"
+#include "../OutputBuffer.hpp"
+
+namespace lox {
+
+static OutputBuffer output(std::cout);
+
+void Value::operandsMustBeNumbers(int line) {
+  throw RuntimeError(line, "Operands must be numbers.");
+}
+
+Value Value::concat(const Value& right, int line) const {
+  if(is(Object::Type::STRING) && right.is(Object::Type::STRING)) {
+    return string(as<String>().text + right.as<String>().text);
+  }
+  throw RuntimeError(line, "Operands must be two numbers or two strings.");
+}
+
+bool Value::stringEquals(const Value& right) const {
+  // Other objects are never equal, not even to themselves, as in the
+  // interpreter.
+  return is(Object::Type::STRING) && right.is(Object::Type::STRING) && as<String>().text == right.as<String>().text;
+}
+
+void Value::Invocation::arityMismatch(int arity, size_t count, int line) {
+  throw RuntimeError(line, "Expected " + std::to_string(arity) + " arguments but got " + std::to_string(count) + ".");
+}
+
+Value Value::callObject(std::initializer_list<Value> arguments, int line) const {
+  if(is(Object::Type::NATIVE)) {
+    Native& native = as<Native>();
+    if(arguments.size() != static_cast<size_t>(native.arity)) Invocation::arityMismatch(native.arity, arguments.size(), line);
+    return native.code(arguments.begin());
+  }
+  if(is(Object::Type::CLASS)) {
+    Value instance = new Instance(&as<Class>());
+    Function* initializer = as<Class>().findMethod("init");
+    int arity = initializer == nullptr ? 0 : initializer->arity;
+    if(arguments.size() != static_cast<size_t>(arity)) Invocation::arityMismatch(arity, arguments.size(), line);
+    if(initializer != nullptr) initializer->code(*initializer, instance, arguments.begin());
+    return instance;
+  }
+  throw RuntimeError(line, "Can only call functions and classes.");
+}
+
+static Value bind(Function& method, const Value& receiver) {
+  Function* bound = new Function(method.name, method.arity, method.code, method.initializer, method.captures);
+  bound->receiver = receiver;
+  return bound;
+}
+
+Value Value::get(const std::string& name, int line) const {
+  if(!is(Object::Type::INSTANCE)) throw RuntimeError(line, "Only instances have properties.");
+  Instance& instance = as<Instance>();
+  auto field = instance.fields.find(name);
+  if(field != instance.fields.end()) return field->second;
+  if(Function* method = instance.klass->findMethod(name)) return bind(*method, *this);
+  throw RuntimeError(line, "Undefined property '" + name + "'.");
+}
+
+Value::Invocation Value::invoke(const std::string& name, int line) const {
+  if(!is(Object::Type::INSTANCE)) throw RuntimeError(line, "Only instances have properties.");
+  Instance& instance = as<Instance>();
+  auto field = instance.fields.find(name);
+  if(field != instance.fields.end()) return Invocation{nullptr, Value(), field->second};
+  if(Function* method = instance.klass->findMethod(name)) return Invocation{method, *this, Value()};
+  throw RuntimeError(line, "Undefined property '" + name + "'.");
+}
+
+Function* Class::findMethod(const std::string& name) const {
+  auto method = methods.find(name);
+  if(method != methods.end()) return method->second.get();
+  if(superclass) return superclass->findMethod(name);
+  return nullptr;
+}
+
+Value Instance::set(const std::string& name, Value value) {
+  fields[name] = value;
+  return value;
+}
+
+void Global::undefined(int line) const {
+  throw RuntimeError(line, "Undefined variable '" + std::string(name) + "'.");
+}
+
+Value makeClass(const char* name, const Value& superclass, int line, std::initializer_list<std::pair<const char*, Value>> methods) {
+  Ref<Class> parent;
+  if(superclass.getKind() != Value::Kind::NIL) {
+    if(!superclass.is(Object::Type::CLASS)) throw RuntimeError(line, "Superclass must be a class.");
+    parent = &superclass.as<Class>();
+  }
+  Class* klass = new Class(name, std::move(parent));
+  Value value = klass;
+  for(const auto& [methodName, method] : methods) {
+    klass->methods[methodName] = &method.as<Function>();
+  }
+  return value;
+}
+
+Instance& fields(const Value& object, int line) {
+  if(!object.is(Object::Type::INSTANCE)) throw RuntimeError(line, "Only instances have fields.");
+  return object.as<Instance>();
+}
+
+Value superMethod(const Value& superclass, const Value& receiver, const std::string& name, int line) {
+  Function* method = superclass.as<Class>().findMethod(name);
+  if(method == nullptr) throw RuntimeError(line, "Undefined property '" + name + "'.");
+  return bind(*method, receiver);
+}
+
+Value clockNative() {
+  return new Native("clock", 0, [](const Value*) -> Value {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration<double>(now).count();
+  });
+}
+
+static std::string stringify(const Value& value) {
+  switch(value.getKind()) {
+    case Value::Kind::NIL: return "nil";
+    case Value::Kind::BOOL: return value.asBool() ? "true" : "false";
+    case Value::Kind::NUMBER: {
+      char text[OutputBuffer::maxNumberLength];
+      return std::string(text, OutputBuffer::formatNumber(text, text + sizeof(text), value.asNumber()));
+    }
+    case Value::Kind::OBJECT: break;
+  }
+  switch(value.asObject()->type) {
+    case Object::Type::STRING: return value.as<String>().text;
+    case Object::Type::FUNCTION: return "<fn " + std::string(value.as<Function>().name) + ">";
+    case Object::Type::NATIVE: return "<native fn " + std::string(value.as<Native>().name) + ">";
+    case Object::Type::CLASS: return value.as<Class>().name;
+    case Object::Type::INSTANCE: return value.as<Instance>().klass->name + " instance";
+    case Object::Type::CELL: break;
+  }
+  return "Error in stringify: Object type not recognized.\n";
+}
+
+void print(const Value& value) {
+  if(value.isNumber()) {
+    output.writeNumber(value.asNumber());
+  } else if(value.is(Object::Type::STRING)) {
+    output.write(value.as<String>().text);
+  } else {
+    output.write(stringify(value));
+  }
+  output.newline();
+}
+
+int run(void (*script)()) {
+  try {
+    script();
+  } catch(RuntimeError& error) {
+    output.flush();
+    std::cerr << error.what() << "\n[line " << error.line << "]\n";
+    return 70;
+  }
+  output.flush();
+  return 0;
+}
+
+}
@@ -0,0 +1,291 @@
+#ifndef __LOXRUNTIME_H
+#define __LOXRUNTIME_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The runtime library that programs generated by --emit-cpp link against.
+// It has the interpreter's values, classes, instances and closures with
+// the same semantics and error messages, but none of its machinery: a
+// value is a tagged union instead of a std::any, objects are reference
+// counted without atomics, and a Lox function is a plain C++ function.
+//
+// Generated code keeps Lox's left-to-right evaluation order by calling
+// the operators below as members of their left operand: C++17 evaluates
+// the object expression of a member call before the arguments.
+namespace lox {
+
+class Value;
+
+struct Object {
+  enum class Type : uint8_t {
+    STRING,
+    FUNCTION,
+    NATIVE,
+    CLASS,
+    INSTANCE,
+    CELL
+  };
+
+  const Type type;
+  uint32_t references = 0;
+
+  explicit Object(Type type) : type{type} {}
+  Object(const Object&) = delete;
+  Object& operator=(const Object&) = delete;
+  virtual ~Object() = default;
+};
+
+// An owning pointer to an object, counted in the object itself.
+template<class T>
+class Ref {
+  T* pointer = nullptr;
+public:
+  Ref() = default;
+  Ref(T* pointer) : pointer{pointer} { if(pointer != nullptr) pointer->references++; }
+  Ref(const Ref& other) : Ref(other.pointer) {}
+  Ref(Ref&& other) noexcept : pointer{other.pointer} { other.pointer = nullptr; }
+  ~Ref() { if(pointer != nullptr && --pointer->references == 0) delete pointer; }
+  Ref& operator=(Ref other) { std::swap(pointer, other.pointer); return *this; }
+
+  T* get() const { return pointer; }
+  T* operator->() const { return pointer; }
+  T& operator*() const { return *pointer; }
+  explicit operator bool() const { return pointer != nullptr; }
+};
+
+class Value {
+public:
+  enum class Kind : uint8_t {
+    NIL,
+    BOOL,
+    NUMBER,
+    OBJECT
+  };
+
+  Value() : kind{Kind::NIL}, number{0} {}
+  Value(bool boolean) : kind{Kind::BOOL}, boolean{boolean} {}
+  Value(double number) : kind{Kind::NUMBER}, number{number} {}
+  Value(Object* object) : kind{Kind::OBJECT}, object{object} { object->references++; }
+  Value(const char*) = delete;
+  Value(const Value& other) : kind{other.kind}, number{other.number} { retain(); }
+  Value(Value&& other) noexcept : kind{other.kind}, number{other.number} { other.kind = Kind::NIL; }
+  ~Value() { release(); }
+  Value& operator=(const Value& other) {
+    if(other.kind == Kind::OBJECT) other.object->references++;
+    release();
+    kind = other.kind;
+    number = other.number;
+    return *this;
+  }
+  Value& operator=(Value&& other) noexcept {
+    if(this != &other) {
+      release();
+      kind = other.kind;
+      number = other.number;
+      other.kind = Kind::NIL;
+    }
+    return *this;
+  }
+
+  Kind getKind() const { return kind; }
+  bool isNumber() const { return kind == Kind::NUMBER; }
+  bool is(Object::Type type) const { return kind == Kind::OBJECT && object->type == type; }
+  double asNumber() const { return number; }
+  bool asBool() const { return boolean; }
+  Object* asObject() const { return object; }
+  template<class T> T& as() const { return *static_cast<T*>(object); }
+
+  // Only false is falsey; nil is truthy, as in the interpreter.
+  bool truthy() const { return kind != Kind::BOOL || boolean; }
+
+  Value add(const Value& right, int line) const {
+    if(kind == Kind::NUMBER && right.kind == Kind::NUMBER) return number + right.number;
+    return concat(right, line);
+  }
+  Value subtract(const Value& right, int line) const { numbers(right, line); return number - right.number; }
+  Value multiply(const Value& right, int line) const { numbers(right, line); return number * right.number; }
+  Value divide(const Value& right, int line) const { numbers(right, line); return number / right.number; }
+  Value less(const Value& right, int line) const { numbers(right, line); return number < right.number; }
+  Value lessEqual(const Value& right, int line) const { numbers(right, line); return number <= right.number; }
+  Value greater(const Value& right, int line) const { numbers(right, line); return number > right.number; }
+  Value greaterEqual(const Value& right, int line) const { numbers(right, line); return number >= right.number; }
+  Value negate(int line) const { numbers(*this, line); return -number; }
+  bool equals(const Value& right) const {
+    if(kind != right.kind) return false;
+    switch(kind) {
+      case Kind::NIL: return true;
+      case Kind::BOOL: return boolean == right.boolean;
+      case Kind::NUMBER: return number == right.number;
+      default: return stringEquals(right);
+    }
+  }
+
+  Value call(std::initializer_list<Value> arguments, int line) const;
+  // A property read: a field, or a method bound to the instance.
+  Value get(const std::string& name, int line) const;
+  // A property read that is called right away. Methods are called with
+  // the instance as receiver instead of being bound first.
+  struct Invocation;
+  Invocation invoke(const std::string& name, int line) const;
+
+private:
+  Kind kind;
+  union {
+    bool boolean;
+    double number;
+    Object* object;
+  };
+
+  void retain() const { if(kind == Kind::OBJECT) object->references++; }
+  void release() { if(kind == Kind::OBJECT && --object->references == 0) delete object; }
+  void numbers(const Value& right, int line) const {
+    if(kind != Kind::NUMBER || right.kind != Kind::NUMBER) operandsMustBeNumbers(line);
+  }
+  [[noreturn]] static void operandsMustBeNumbers(int line);
+  Value concat(const Value& right, int line) const;
+  bool stringEquals(const Value& right) const;
+  Value callObject(std::initializer_list<Value> arguments, int line) const;
+};
+
+// Thrown for a Lox runtime error and reported by run() like the
+// interpreter does.
+class RuntimeError : public std::runtime_error {
+public:
+  const int line;
+  RuntimeError(int line, const std::string& message)
+    : std::runtime_error(message), line{line} {}
+};
+
+struct String : Object {
+  const std::string text;
+  explicit String(std::string text) : Object{Type::STRING}, text{std::move(text)} {}
+};
+
+// A captured local, shared by the function that declares it and the
+// closures that use it.
+struct Cell : Object {
+  Value value;
+  explicit Cell(Value value) : Object{Type::CELL}, value{std::move(value)} {}
+};
+
+struct Function : Object {
+  using Code = Value (*)(Function& self, const Value& receiver, const Value* arguments);
+
+  const char* const name;
+  const int arity;
+  const Code code;
+  const bool initializer;
+  std::vector<Ref<Cell>> captures;
+  // `this` for a method bound to an instance, nil otherwise.
+  Value receiver;
+
+  Function(const char* name, int arity, Code code, bool initializer, std::vector<Ref<Cell>> captures)
+    : Object{Type::FUNCTION}, name{name}, arity{arity}, code{code}, initializer{initializer}, captures{std::move(captures)} {}
+};
+
+struct Native : Object {
+  using Code = Value (*)(const Value* arguments);
+
+  const char* const name;
+  const int arity;
+  const Code code;
+
+  Native(const char* name, int arity, Code code)
+    : Object{Type::NATIVE}, name{name}, arity{arity}, code{code} {}
+};
+
+struct Class : Object {
+  const std::string name;
+  const Ref<Class> superclass;
+  std::unordered_map<std::string, Ref<Function>> methods;
+
+  Class(std::string name, Ref<Class> superclass)
+    : Object{Type::CLASS}, name{std::move(name)}, superclass{std::move(superclass)} {}
+  Function* findMethod(const std::string& name) const;
+};
+
+struct Instance : Object {
+  const Ref<Class> klass;
+  std::unordered_map<std::string, Value> fields;
+
+  explicit Instance(Ref<Class> klass) : Object{Type::INSTANCE}, klass{std::move(klass)} {}
+  // Sets a field and returns the value, like an assignment expression.
+  Value set(const std::string& name, Value value);
+};
+
+// A callee found by Value::invoke: a method and its receiver, or any
+// other value to call.
+struct Value::Invocation {
+  Function* method;
+  Value receiver;
+  Value callee;
+
+  Value call(std::initializer_list<Value> arguments, int line) const {
+    if(method == nullptr) return callee.call(arguments, line);
+    if(arguments.size() != static_cast<size_t>(method->arity)) arityMismatch(method->arity, arguments.size(), line);
+    return method->code(*method, receiver, arguments.begin());
+  }
+  [[noreturn]] static void arityMismatch(int arity, size_t count, int line);
+};
+
+inline Value Value::call(std::initializer_list<Value> arguments, int line) const {
+  if(is(Object::Type::FUNCTION)) {
+    Function& function = as<Function>();
+    if(arguments.size() != static_cast<size_t>(function.arity)) Invocation::arityMismatch(function.arity, arguments.size(), line);
+    return function.code(function, function.receiver, arguments.begin());
+  }
+  return callObject(arguments, line);
+}
+
+// A global variable. Reading or assigning it before it is defined is a
+// runtime error, as in the interpreter.
+struct Global {
+  const char* const name;
+  Value value;
+  bool defined = false;
+
+  explicit Global(const char* name) : name{name} {}
+  Global(const char* name, Value value) : name{name}, value{std::move(value)}, defined{true} {}
+
+  const Value& get(int line) const {
+    if(!defined) undefined(line);
+    return value;
+  }
+  Value assign(Value newValue, int line) {
+    if(!defined) undefined(line);
+    value = std::move(newValue);
+    return value;
+  }
+  void define(Value newValue) {
+    value = std::move(newValue);
+    defined = true;
+  }
+  [[noreturn]] void undefined(int line) const;
+};
+
+inline Value string(std::string text) { return new String(std::move(text)); }
+inline Ref<Cell> cell(Value value) { return new Cell(std::move(value)); }
+inline Value function(const char* name, int arity, Function::Code code, std::vector<Ref<Cell>> captures, bool initializer = false) {
+  return new Function(name, arity, code, initializer, std::move(captures));
+}
+// Creates a class; `superclass` is nil or must be a class.
+Value makeClass(const char* name, const Value& superclass, int line, std::initializer_list<std::pair<const char*, Value>> methods);
+// Sets a field; the object is checked before the value is evaluated.
+Instance& fields(const Value& object, int line);
+// `super.name` in a method whose receiver is `receiver`.
+Value superMethod(const Value& superclass, const Value& receiver, const std::string& name, int line);
+Value clockNative();
+void print(const Value& value);
+// Runs the script's top-level code, reports a runtime error like the
+// interpreter and returns the process exit status.
+int run(void (*script)());
+
+}
+
+#endif